@@ -9,6 +9,7 @@ extern "C" {
 #include <stddef.h>
 #include <stdio.h>
 
+#include "pancl/pancl_build.h"
 #include "pancl/pancl_error.h"
 #include "pancl/types/array.h"
 #include "pancl/types/custom.h"
@@ -20,8 +21,101 @@ extern "C" {
 #include "pancl/types/utf8_string.h"
 #include "pancl/types/value.h"
 
+/**
+ * ABI version of the public structures.  Bumped (along with the shared
+ * library's soname) whenever the layout of a public structure changes.
+ * Applications can compare this against pancl_lib_abi_version() to detect
+ * being run against an incompatible library.
+ */
+#define PANCL_ABI_VERSION  5
+
 struct pancl_parse_operations;
+struct pancl_pool;
+
+/**
+ * Arena mode: every node of a parsed table is bump-allocated from large
+ * chunks owned by the context.  pancl_table_fini() then costs O(1) and the
+ * chunks are recycled by the next pancl_get_next_table() once no parsed
+ * tables remain alive.
+ */
+#define PANCL_PARSE_ARENA  (1u << 0)
+/**
+ * Intern names: every distinct entry name, table name and custom type name
+ * is stored once and shared by all tables parsed through the context (and
+ * alive at the same time).  Equal names then have equal pancl_string_data()
+ * pointers, so they can be compared by pointer.  Interned strings must not
+ * be modified.
+ *
+ * The strings belong to the context's pool: names from tables parsed
+ * through different contexts are separate copies and have to be compared
+ * by content, and the tables sharing them must not be cleaned up on
+ * different threads at the same time (see struct pancl_context).
+ */
+#define PANCL_PARSE_INTERN_KEYS  (1u << 1)
+/**
+ * Intern string values, like PANCL_PARSE_INTERN_KEYS does for names.  The
+ * same limits apply: pointers only compare equal within one context, and
+ * its tables must be released from one thread at a time.
+ */
+#define PANCL_PARSE_INTERN_STRINGS  (1u << 2)
+/**
+ * Don't work out the locations of tables, entries and values; their @p loc
+ * members stay zeroed.  The lexer then only counts lines, and works out the
+ * rest of pancl_context.error_loc once something fails.  Building with
+ * PANCL_NO_LOCATIONS (see pancl/pancl_build.h) removes the members too.
+ */
+#define PANCL_PARSE_NO_LOCATIONS  (1u << 3)
+/**
+ * Recycle nodes: small blocks (values, entries, short strings and
+ * containers) are carved out of chunks owned by the context, and
+ * pancl_table_fini() puts them on free lists for the next
+ * pancl_get_next_table().  Streaming a document table by table then soon
+ * stops calling the allocator.  Like arena mode and interning this makes
+ * the tables share the context's pool (see struct pancl_context).
+ */
+#define PANCL_PARSE_RECYCLE  (1u << 4)
+
+/**
+ * Smallest read buffer pancl_context_set_buffer_size() accepts: enough for
+ * the rest of any UTF-8 sequence cut off by the previous read.  Anything
+ * this small is only useful for testing.
+ */
+#define PANCL_BUFFER_SIZE_MIN  (8)
+
+/**
+ * Allocator used by a single pancl_context and the tables parsed with it.
+ *
+ * Unlike the functions given to pancl_lib_set_allocators() every callback
+ * receives @p state, and the size of a block is passed back when it is
+ * resized or freed, so sized/region allocators need no headers of their own.
+ */
+struct pancl_allocator {
+	/** Allocates @p size bytes (malloc) */
+	void *(*alloc)(void *state, size_t size);
+	/** Resizes a block of @p old_size bytes to @p new_size bytes (realloc) */
+	void *(*realloc)(void *state, void *ptr, size_t old_size,
+			size_t new_size);
+	/** Releases a block of @p size bytes (free); @p ptr is never NULL */
+	void (*free)(void *state, void *ptr, size_t size);
+	void *state; /**< Passed to every callback */
+};
 
+/**
+ * Parse state for one input.
+ *
+ * With PANCL_PARSE_ARENA, PANCL_PARSE_RECYCLE or PANCL_PARSE_INTERN_* every
+ * table parsed through a context shares the context's node pool (see
+ * pancl_table.pool), which does no locking.  pancl_table_fini() and
+ * pancl_table_shrink_to_fit() on those tables, pancl_get_next_table() and
+ * pancl_context_fini() must then never run at the same time on different
+ * threads; releasing all of them on one thread is simplest.  Memory freed
+ * by pancl_table_fini() stays in the pool for the next table and is only
+ * handed back to the allocator once the context and all of its tables have
+ * been cleaned up.
+ *
+ * Without those flags tables share nothing with each other or the context,
+ * and every node is a separate allocation.
+ */
 struct pancl_context {
 	void *ops_data; /**< Operations user data */
 	const struct pancl_parse_operations *ops; /**< Parsing operations */
@@ -32,13 +126,38 @@ struct pancl_context {
 	const char *cursor; /**< Current position in the buffer. */
 	const char *end; /**< End pointer. */
 
-	struct pancl_location loc; /**< Column/line number */
+	/**
+	 * Line number, and the column and byte offset as of @p loc_cursor.  The
+	 * lexer only works these out when asked, see pancl_context_location().
+	 */
+	struct pancl_location loc;
+	const char *loc_cursor; /**< Internal use */
 	/* Note: Error data is not exact. */
 	struct pancl_location error_loc; /**< Error column/line number */
 	struct pancl_utf8_string *error_token; /**< Error token (can be NULL) */
 
 	int end_of_input; /**< No more input data available */
+	int input_valid; /**< Internal use */
 	void *token1; /**< Internal use */
+	void *token_buffer; /**< Internal use */
+
+	/**
+	 * PANCL_PARSE_* flags.  May be set any time after pancl_context_init()
+	 * and before the first call to pancl_get_next_table(); pancl_parse_*()
+	 * preserves them.
+	 */
+	unsigned int flags;
+	struct pancl_pool *pool; /**< Internal use */
+	/**
+	 * Allocator for everything parsed through this context, set with
+	 * pancl_context_set_allocator().  All NULL uses the library defaults.
+	 */
+	struct pancl_allocator allocator;
+	/**
+	 * Read buffer size for pancl_parse_file() and pancl_parse_fd(), set
+	 * with pancl_context_set_buffer_size().  0 sizes it from the input.
+	 */
+	size_t read_size;
 };
 
 /**
@@ -56,6 +175,42 @@ void pancl_context_init(struct pancl_context *ctx);
  * @note It is safe to call this function multiple times on the same context.
  */
 void pancl_context_fini(struct pancl_context *ctx);
+/**
+ * Makes a context (and every table parsed through it) allocate memory with
+ * @p allocator instead of the library wide allocators.
+ *
+ * @param[in] ctx         Context to configure
+ * @param[in] allocator   Allocator to copy, NULL restores the defaults
+ *
+ * @retval PANCL_SUCCESS             Success
+ * @retval PANCL_ERROR_ARG_INVALID   A callback is missing, or @p ctx has
+ *                                   already been used for parsing
+ *
+ * @note
+ *   Must be called after pancl_context_init() and before pancl_parse_*().
+ *   pancl_parse_*() preserves the allocator; pancl_context_fini() resets it.
+ *   Tables parsed with the allocator keep using it (and @p state) until
+ *   pancl_table_fini(), even after the context is gone.
+ */
+int pancl_context_set_allocator(struct pancl_context *ctx,
+		const struct pancl_allocator *allocator);
+/**
+ * Sets the size of the buffer pancl_parse_file() and pancl_parse_fd() read
+ * the input into.
+ *
+ * @param[in] ctx    Context to configure
+ * @param[in] size   Buffer size in bytes, 0 picks one from the input
+ *
+ * @retval PANCL_SUCCESS             Success
+ * @retval PANCL_ERROR_ARG_INVALID   @p ctx is NULL or @p size is non-zero
+ *                                   and below PANCL_BUFFER_SIZE_MIN
+ *
+ * @note
+ *   Takes effect with the next pancl_parse_*(), which preserves it;
+ *   pancl_context_fini() resets it.  By default regular files are read in
+ *   one go up to 1 MiB, anything else in blocks of at least 8 KiB.
+ */
+int pancl_context_set_buffer_size(struct pancl_context *ctx, size_t size);
 
 /**
  * Start parsing a PanCL file.
@@ -71,6 +226,22 @@ void pancl_context_fini(struct pancl_context *ctx);
  *   on @p ctx.
  */
 int pancl_parse_file(struct pancl_context *ctx, FILE *file);
+/**
+ * Start parsing a PanCL file from a file descriptor.  The input is read(2)
+ * straight into the context's buffer, without going through stdio.
+ *
+ * @param[in] ctx   Context to initialize and store parsing state in
+ * @param[in] fd    Descriptor open for reading
+ *
+ * @retval PANCL_SUCCESS   Setup successful
+ * @retval PANCL_ERROR_*   Something went wrong
+ *
+ * @note
+ *   Like pancl_parse_file() this starts at the beginning of the file if
+ *   @p fd is seekable.  @p fd should remain open until pancl_context_fini()
+ *   has been called on @p ctx.
+ */
+int pancl_parse_fd(struct pancl_context *ctx, int fd);
 /**
  * Start parsing PanCL data from a string.
  *
@@ -113,7 +284,22 @@ int pancl_parse_buffer(struct pancl_context *ctx, const void *buffer,
 const char *pancl_strerror(int pancl_error_code);
 
 /**
- * Set the allocation functions for the entire PanCL library.
+ * Retrieves the ABI version the library was built with.
+ *
+ * @return Returns the library's PANCL_ABI_VERSION.
+ */
+int pancl_lib_abi_version(void);
+/**
+ * Retrieves the layout-affecting build options the library was built with.
+ *
+ * @return Returns the library's PANCL_BUILD_FLAGS.
+ */
+unsigned int pancl_lib_build_flags(void);
+
+/**
+ * Set the allocation functions for the entire PanCL library.  These are used
+ * by contexts without an allocator of their own and by the
+ * pancl_*_destroy() functions.
  *
  * @param[in] alloc_fn     Basic allocation function (malloc)
  * @param[in] realloc_fn   Specialized reallocation function (realloc)
@@ -142,6 +328,20 @@ int pancl_lib_set_allocators(void *(*alloc_fn)(size_t),
  */
 int pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table);
 
+/**
+ * Retrieves the current position of the parser in its input: just past the
+ * last token it read.
+ *
+ * @param[in] ctx   Context attached to some form of input (pancl_parse_*)
+ * @param[out] loc  Location to store the position in
+ *
+ * @note
+ *   Columns and offsets are worked out on demand, ctx->loc on its own only
+ *   has the right line number.  The length is always 0.
+ */
+void pancl_context_location(struct pancl_context *ctx,
+		struct pancl_location *loc);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef H_PANCL_BUILD
+#define H_PANCL_BUILD
+
+/* Compile-time options that change the layout of public structures.  The
+ * library and everything using it have to be built with the same options;
+ * compare pancl_lib_build_flags() against PANCL_BUILD_FLAGS to be sure.
+ */
+
+/**
+ * PANCL_INLINE_CONTAINERS: arrays, tuples and table data store their
+ * elements contiguously (struct pancl_value / struct pancl_entry arrays)
+ * instead of as arrays of pointers to individually allocated elements.
+ * Use pancl_array_at(), pancl_tuple_at() and pancl_table_data_at() to
+ * access elements independently of the layout.
+ *
+ * Build the library with `make WITH_INLINE_CONTAINERS=1`.
+ */
+#if defined(PANCL_INLINE_CONTAINERS)
+#  define PANCL_BUILD_INLINE_CONTAINERS  (1u << 0)
+#else
+#  define PANCL_BUILD_INLINE_CONTAINERS  (0u)
+#endif
+
+/**
+ * PANCL_SSO_STRINGS: strings of parsed data (pancl_string members) of up to
+ * PANCL_STRING_INLINE_MAX bytes are stored inside the owning entry, value or
+ * table instead of in a separate allocation.  Use pancl_string_data() and
+ * friends to read them independently of the representation.
+ *
+ * Build the library with `make WITH_SSO_STRINGS=1`.
+ */
+#if defined(PANCL_SSO_STRINGS)
+#  define PANCL_BUILD_SSO_STRINGS  (1u << 1)
+#else
+#  define PANCL_BUILD_SSO_STRINGS  (0u)
+#endif
+
+/**
+ * PANCL_COMPACT_VALUES: a struct pancl_value is just a type and 8 bytes of
+ * data, 16 bytes in all.  Scalars and string pointers are stored inline,
+ * arrays, custom types, tables and tuples in separate allocations.  Use
+ * pancl_value_array() and friends to access those independently of the
+ * layout.  There is no room for a location, so this implies
+ * PANCL_NO_LOCATIONS, and string values have to be pointers, so it can't be
+ * combined with PANCL_SSO_STRINGS.
+ *
+ * Build the library with `make WITH_COMPACT_VALUES=1`.
+ */
+#if defined(PANCL_COMPACT_VALUES)
+#  if defined(PANCL_SSO_STRINGS)
+#    error "PANCL_COMPACT_VALUES and PANCL_SSO_STRINGS can't be combined"
+#  endif
+#  if !defined(PANCL_NO_LOCATIONS)
+#    define PANCL_NO_LOCATIONS
+#  endif
+#  define PANCL_BUILD_COMPACT_VALUES  (1u << 3)
+#else
+#  define PANCL_BUILD_COMPACT_VALUES  (0u)
+#endif
+
+/**
+ * PANCL_NO_LOCATIONS: values, entries, containers and tables have no
+ * @p loc member, and nothing works out where they were in the input.  Errors
+ * are still reported with pancl_context.error_loc.  This is the compile-time
+ * form of PANCL_PARSE_NO_LOCATIONS.
+ *
+ * Build the library with `make WITH_NO_LOCATIONS=1`.
+ */
+#if defined(PANCL_NO_LOCATIONS)
+#  define PANCL_BUILD_NO_LOCATIONS  (1u << 2)
+#else
+#  define PANCL_BUILD_NO_LOCATIONS  (0u)
+#endif
+
+/**
+ * All layout-affecting options the headers were compiled with.
+ */
+#define PANCL_BUILD_FLAGS \
+	(PANCL_BUILD_INLINE_CONTAINERS | PANCL_BUILD_SSO_STRINGS \
+		| PANCL_BUILD_NO_LOCATIONS | PANCL_BUILD_COMPACT_VALUES)
+
+#endif /* H_PANCL_BUILD */
+// vim:ts=4:sw=4:autoindent
@@ -241,6 +241,36 @@
 #define PANCL_ERROR_STR_TO_INT_RANGE_str \
 	"Conversion from string to integer resulted in an overflow"
 
+/**
+ * Conversion from string to floating point had an invalid character.
+ */
+#define PANCL_ERROR_STR_TO_FLOAT_CHAR  9100
+#define PANCL_ERROR_STR_TO_FLOAT_CHAR_str \
+	"Invalid character found when converting from string to floating point"
+
+/**
+ * Conversion from string to floating point gave a value too large for a
+ * double.
+ */
+#define PANCL_ERROR_STR_TO_FLOAT_OVERFLOW  9101
+#define PANCL_ERROR_STR_TO_FLOAT_OVERFLOW_str \
+	"Conversion from string to floating point resulted in an overflow"
+
+/**
+ * Conversion from string to floating point gave a non-zero value too small
+ * for a double.
+ */
+#define PANCL_ERROR_STR_TO_FLOAT_UNDERFLOW  9102
+#define PANCL_ERROR_STR_TO_FLOAT_UNDERFLOW_str \
+	"Conversion from string to floating point resulted in an underflow"
+
+/**
+ * Conversion from string to floating point was given an invalid base.
+ */
+#define PANCL_ERROR_STR_TO_FLOAT_BASE  9103
+#define PANCL_ERROR_STR_TO_FLOAT_BASE_str \
+	"Invalid base during conversion from string to floating point"
+
 /**
  * Optional/extended integer type invalid argument count.
  */
@@ -262,5 +292,26 @@
 #define PANCL_ERROR_OPT_INT_ARG_1_NOT_INT_str \
 	"Second argument to ::Int* or ::Uint* custom type is not an Integer"
 
+/**
+ * ::Float type invalid argument count.
+ */
+#define PANCL_ERROR_OPT_FLOAT_ARG_COUNT  10100
+#define PANCL_ERROR_OPT_FLOAT_ARG_COUNT_str \
+	"Invalid argument count (0 or >2) given to ::Float custom type"
+
+/**
+ * ::Float type's first argument is not a string.
+ */
+#define PANCL_ERROR_OPT_FLOAT_ARG_0_NOT_STRING  10101
+#define PANCL_ERROR_OPT_FLOAT_ARG_0_NOT_STRING_str \
+	"First argument to ::Float custom type is not a String"
+
+/**
+ * ::Float type's second argument is not an integer.
+ */
+#define PANCL_ERROR_OPT_FLOAT_ARG_1_NOT_INT  10102
+#define PANCL_ERROR_OPT_FLOAT_ARG_1_NOT_INT_str \
+	"Second argument to ::Float custom type is not an Integer"
+
 #endif /* H_PANCL_ERROR */
 // vim:ts=4:sw=4:autoindent
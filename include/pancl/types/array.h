@@ -4,6 +4,7 @@
 
 #include <stddef.h>
 
+#include "pancl/pancl_build.h"
 #include "pancl/types/location.h"
 
 struct pancl_value;
@@ -12,24 +13,36 @@ struct pancl_value;
  * Represents an array: [ ... ]
  */
 struct pancl_array {
+#if !defined(PANCL_NO_LOCATIONS)
 	/**
 	 * Where this was found in the input.
 	 */
 	struct pancl_location loc;
+#endif
 	/**
 	 * Number of entries in the values array.
 	 */
 	size_t count;
+	/**
+	 * Number of slots allocated in the values array (>= count).
+	 */
+	size_t capacity;
 	/**
 	 * Entries in the array.  Each entry is guaranteed by the parser to be of
-	 * the same type.  Defreference values[0]->type for the array type.
+	 * the same type.  Check pancl_array_at(array, 0)->type for the array
+	 * type.
 	 *
 	 * If count != 0, then this is guaranteed to be non-NULL.
 	 *
 	 * If this is non-NULL then each pointer pointed to is guaranteed to also
-	 * be non-NULL.
+	 * be non-NULL.  With PANCL_INLINE_CONTAINERS the values are stored
+	 * directly in this array instead.
 	 */
+#if defined(PANCL_INLINE_CONTAINERS)
+	struct pancl_value *values;
+#else
 	struct pancl_value **values;
+#endif
 };
 
 #endif /* H_PANCL_TYPES_ARRAY */
@@ -4,23 +4,25 @@
 
 #include "pancl/types/location.h"
 #include "pancl/types/tuple.h"
+#include "pancl/types/utf8_string.h"
 
-struct pancl_utf8_string;
 
 /**
  * Represents a custom type: name( ... )
  */
 struct pancl_custom {
+#if !defined(PANCL_NO_LOCATIONS)
 	/**
 	 * Where this was found in the input.
 	 */
 	struct pancl_location loc;
+#endif
 	/**
 	 * Name of the custom type.
 	 *
 	 * Guaranteed to be non-NULL and non-empty.
 	 */
-	struct pancl_utf8_string *name;
+	pancl_string name;
 	/**
 	 * Tuple containing the type parameters.  This tuple may be empty.
 	 *
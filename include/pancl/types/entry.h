@@ -2,17 +2,19 @@
 #ifndef H_PANCL_TYPES_ENTRY
 #define H_PANCL_TYPES_ENTRY
 
+#include <stddef.h>
+
 #include "pancl/types/location.h"
 #include "pancl/types/value.h"
 
-struct pancl_utf8_string;
-
 /**
  * Entry in a table (key-value pair).
  */
 struct pancl_entry {
+#if !defined(PANCL_NO_LOCATIONS)
 	struct pancl_location loc;      /**< Where found in the input */
-	struct pancl_utf8_string *name; /**< Name (key) of the entry (non-NULL) */
+#endif
+	pancl_string name;              /**< Name (key) of the entry (non-NULL) */
 	struct pancl_value value;       /**< Associated value (non-NULL) */
 };
 
@@ -22,8 +24,35 @@ struct pancl_entry {
  * @param[in,out] entry   Pointer to the pointer to the entry to clean up
  *
  * @note The dereference of @p entry will be set to NULL on return.
+ * @note
+ *   Parsed entries may only be destroyed one at a time (after taking them
+ *   out of their table) if the table's pancl_table.pool is NULL, i.e. it
+ *   was parsed with the library wide allocators and none of
+ *   PANCL_PARSE_ARENA, PANCL_PARSE_RECYCLE and PANCL_PARSE_INTERN_*.
+ *   Otherwise they belong to the table until pancl_table_fini().
+ * @note
+ *   With PANCL_INLINE_CONTAINERS entries aren't separate allocations and
+ *   can't be destroyed on their own.
  */
 void pancl_entry_destroy(struct pancl_entry **entry);
 
+/**
+ * Retrieves an entry of a pancl_table_data, whatever the container layout.
+ *
+ * @param[in] td      Table data to look into
+ * @param[in] index   Index of the entry, must be less than td->count
+ *
+ * @return Returns the entry at @p index.
+ */
+static inline struct pancl_entry *
+pancl_table_data_at(const struct pancl_table_data *td, size_t index)
+{
+#if defined(PANCL_INLINE_CONTAINERS)
+	return &(td->entries[index]);
+#else
+	return td->entries[index];
+#endif
+}
+
 #endif /* H_PANCL_TYPES_ENTRY */
 // vim:ts=4:sw=4:autoindent
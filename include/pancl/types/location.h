@@ -2,12 +2,26 @@
 #ifndef H_PANCL_TYPES_LOCATION
 #define H_PANCL_TYPES_LOCATION
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pancl/pancl_build.h"
+
 /**
- * Storage for the line/column position of the start of any given data.
+ * Storage for the line/column position of the start of any given data, and
+ * the bytes of the input it spans.  The source text of a table, entry or
+ * value is the @p length bytes at @p offset of the input.
  */
 struct pancl_location {
-	unsigned long column; /**< Column number (0-based) of the current line */
-	unsigned long line; /**< Line number (0-based) */
+	/*
+	 * Every table, entry and value embeds one of these, so line and column
+	 * are kept to 32 bits to hold it at 24 bytes on 64-bit targets.  They
+	 * wrap after 4G lines or columns; offset and length don't.
+	 */
+	uint_least32_t column; /**< Column number (0-based) of the current line */
+	uint_least32_t line; /**< Line number (0-based) */
+	size_t offset; /**< Byte offset (0-based) of the start in the input */
+	size_t length; /**< Length in bytes */
 };
 
 #endif /* H_PANCL_TYPES_LOCATION */
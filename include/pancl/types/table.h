@@ -2,10 +2,13 @@
 #ifndef H_PANCL_TYPES_TABLE
 #define H_PANCL_TYPES_TABLE
 
+#include <stddef.h>
+
 #include "pancl/types/location.h"
 #include "pancl/types/table_data.h"
+#include "pancl/types/utf8_string.h"
 
-struct pancl_utf8_string;
+struct pancl_pool;
 
 /**
  * Top-level table:
@@ -14,22 +17,30 @@ struct pancl_utf8_string;
  *  ...
  */
 struct pancl_table {
+#if !defined(PANCL_NO_LOCATIONS)
 	/**
 	 * Location (column and line number) of where the table was found in the
-	 * input.
+	 * input.  It spans the header up to the last entry; the root table
+	 * starts with its first entry.  data.loc is the same span.
 	 */
 	struct pancl_location loc;
+#endif
 	/**
 	 * Name of the table.  Note that the very first table in a file may be NULL
-	 * which represents values in the root table instead of those under a table
-	 * header ([...])
+	 * (see pancl_string_is_null()) which represents values in the root table
+	 * instead of those under a table header ([...])
 	 */
-	struct pancl_utf8_string *name;
+	pancl_string name;
 	/**
 	 * Data associated with the table.
 	 * May be NULL.
 	 */
 	struct pancl_table_data data;
+	/**
+	 * Memory pool the table contents were allocated from (internal use).
+	 * NULL when the contents use the library wide allocators.
+	 */
+	struct pancl_pool *pool;
 };
 
 /**
@@ -45,8 +56,31 @@ void pancl_table_init(struct pancl_table *table);
  * @param[in] table   Table to clean up
  *
  * @note It is safe to call this function multiple times with the same table.
+ * @note
+ *   Tables parsed in arena mode (PANCL_PARSE_ARENA) are released in O(1)
+ *   without visiting any of their nodes.
+ * @note
+ *   Tables parsed through the same pancl_context with PANCL_PARSE_ARENA,
+ *   PANCL_PARSE_RECYCLE or PANCL_PARSE_INTERN_* share its memory pool, so
+ *   they must not be cleaned up on different threads at the same time.
  */
 void pancl_table_fini(struct pancl_table *table);
 
+/**
+ * Release the unused capacity of every container (entries, arrays, tuples,
+ * inline tables) held by a pancl_table.
+ *
+ * @param[in] table   Table to trim
+ *
+ * @retval PANCL_SUCCESS             Success
+ * @retval PANCL_ERROR_ARG_INVALID   @p table is NULL
+ * @retval PANCL_ERROR_*             Allocation failures
+ *
+ * @note
+ *   Tables parsed in arena mode (PANCL_PARSE_ARENA) can't give memory back
+ *   so this is a no-op for them.
+ */
+int pancl_table_shrink_to_fit(struct pancl_table *table);
+
 #endif /* H_PANCL_TYPES_TABLE */
 // vim:ts=4:sw=4:autoindent
@@ -4,6 +4,7 @@
 
 #include <stddef.h>
 
+#include "pancl/pancl_build.h"
 #include "pancl/types/location.h"
 
 struct pancl_entry;
@@ -16,23 +17,35 @@ struct pancl_entry;
  *   { ... }
  */
 struct pancl_table_data {
+#if !defined(PANCL_NO_LOCATIONS)
 	/**
-	 * Where this data was found in the input.
+	 * Where this data was found in the input: the braces of an inline table,
+	 * or the whole of a top level table.
 	 */
 	struct pancl_location loc;
+#endif
 	/**
 	 * Number of entries in the table.
 	 */
 	size_t count;
+	/**
+	 * Number of slots allocated in the entries array (>= count).
+	 */
+	size_t capacity;
 	/**
 	 * Entries in the table.
 	 *
 	 * If count != 0, then this is guaranteed to be non-NULL.
 	 *
 	 * If this is non-NULL then each pointer pointed to is guaranteed to also
-	 * be non-NULL.
+	 * be non-NULL.  With PANCL_INLINE_CONTAINERS the entries are stored
+	 * directly in this array instead.
 	 */
+#if defined(PANCL_INLINE_CONTAINERS)
+	struct pancl_entry *entries;
+#else
 	struct pancl_entry **entries;
+#endif
 };
 
 #endif /* H_PANCL_TYPES_TABLE_DATA */
@@ -5,6 +5,8 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "pancl/pancl_build.h"
+
 /**
  * Represents an UTF-8 encoded string.
  */
@@ -44,6 +46,12 @@ struct pancl_utf8_string {
  * @param[in,out] string   Pointer to the pointer to the string to clean up
  *
  * @note The dereference of @p string will be set to NULL on return.
+ * @note
+ *   Parsed strings may only be destroyed one at a time (after taking them
+ *   out of their table) if the table's pancl_table.pool is NULL, i.e. it
+ *   was parsed with the library wide allocators and none of
+ *   PANCL_PARSE_ARENA, PANCL_PARSE_RECYCLE and PANCL_PARSE_INTERN_*.
+ *   Otherwise they belong to the table until pancl_table_fini().
  */
 void pancl_utf8_string_destroy(struct pancl_utf8_string **string);
 
@@ -76,5 +84,156 @@ pancl_utf8_string_is_ascii(const struct pancl_utf8_string *string)
 	return (string->codepoints == string->bytes);
 }
 
+
+#if defined(PANCL_SSO_STRINGS)
+/**
+ * Longest string (in bytes) a pancl_string stores inline.
+ */
+#define PANCL_STRING_INLINE_MAX  21
+/**
+ * pancl_sso_string::tag of a string stored in a pancl_utf8_string.
+ */
+#define PANCL_STRING_HEAP  0xff
+
+/**
+ * Small-string-optimized storage for strings of parsed data.  Strings of up
+ * to PANCL_STRING_INLINE_MAX bytes are kept inside the structure, longer
+ * ones in a separately allocated pancl_utf8_string.
+ *
+ * Use the pancl_string_*() functions instead of accessing the members.
+ */
+struct pancl_sso_string {
+	/**
+	 * Inline (NUL terminated) string, or the pancl_utf8_string pointer of
+	 * a heap string.
+	 */
+	char data[PANCL_STRING_INLINE_MAX + 1];
+	/**
+	 * 0 when no string is set, PANCL_STRING_HEAP for heap strings, and
+	 * the number of bytes + 1 for inline strings.
+	 */
+	unsigned char tag;
+	unsigned char codepoints; /**< Codepoints of an inline string */
+};
+
+/**
+ * String member of parsed data (entry and table names, string values and
+ * custom type names).
+ */
+typedef struct pancl_sso_string pancl_string;
+
+static inline const struct pancl_utf8_string *
+pancl_sso_string_heap(const struct pancl_sso_string *string)
+{
+	const struct pancl_utf8_string *heap;
+
+	memcpy(&heap, string->data, sizeof(heap));
+	return heap;
+}
+#else
+/**
+ * String member of parsed data (entry and table names, string values and
+ * custom type names).  May be NULL where documented.
+ */
+typedef struct pancl_utf8_string *pancl_string;
+#endif
+
+/**
+ * Test if no string is stored in a pancl_string.
+ *
+ * @retval 0          A string is set
+ * @retval non-zero   No string is set (the NULL string)
+ */
+static inline int
+pancl_string_is_null(const pancl_string *string)
+{
+#if defined(PANCL_SSO_STRINGS)
+	return (string->tag == 0);
+#else
+	return (*string == NULL);
+#endif
+}
+
+/**
+ * Retrieves the NUL terminated UTF-8 data of a pancl_string.
+ *
+ * @return Returns the data, or NULL if no string is set.
+ */
+static inline const char *
+pancl_string_data(const pancl_string *string)
+{
+#if defined(PANCL_SSO_STRINGS)
+	if (string->tag == PANCL_STRING_HEAP)
+		return pancl_sso_string_heap(string)->data;
+	return (string->tag == 0) ? NULL : string->data;
+#else
+	return (*string == NULL) ? NULL : (*string)->data;
+#endif
+}
+
+/**
+ * Retrieves the number of bytes (excluding the NUL terminator) in a
+ * pancl_string.
+ *
+ * @return Returns the length in bytes, 0 if no string is set.
+ */
+static inline size_t
+pancl_string_bytes(const pancl_string *string)
+{
+#if defined(PANCL_SSO_STRINGS)
+	if (string->tag == PANCL_STRING_HEAP)
+		return pancl_sso_string_heap(string)->bytes;
+	return (string->tag == 0) ? 0 : (size_t)(string->tag - 1);
+#else
+	return (*string == NULL) ? 0 : (*string)->bytes;
+#endif
+}
+
+/**
+ * Retrieves the number of UTF-8 codepoints in a pancl_string.
+ *
+ * @return Returns the length in codepoints, 0 if no string is set.
+ */
+static inline size_t
+pancl_string_codepoints(const pancl_string *string)
+{
+#if defined(PANCL_SSO_STRINGS)
+	if (string->tag == PANCL_STRING_HEAP)
+		return pancl_sso_string_heap(string)->codepoints;
+	return string->codepoints;
+#else
+	return (*string == NULL) ? 0 : (*string)->codepoints;
+#endif
+}
+
+/**
+ * Test if a pancl_string contains an embedded NUL-byte (outside of the
+ * NUL-terminator).
+ *
+ * @retval 0          String is does not have an embedded NUL.
+ * @retval non-zero   String is has an embedded NUL.
+ */
+static inline int
+pancl_string_contains_nul(const pancl_string *string)
+{
+	if (pancl_string_is_null(string))
+		return 0;
+	return (strlen(pancl_string_data(string)) != pancl_string_bytes(string));
+}
+
+/**
+ * Test if a pancl_string looks like an ASCII string.
+ *
+ * @retval 0          String is not ASCII (or not set)
+ * @retval non-zero   String is ASCII
+ */
+static inline int
+pancl_string_is_ascii(const pancl_string *string)
+{
+	if (pancl_string_is_null(string))
+		return 0;
+	return (pancl_string_codepoints(string) == pancl_string_bytes(string));
+}
+
 #endif /* H_PANCL_TYPES_UTF8_STRING */
 // vim:ts=4:sw=4:autoindent
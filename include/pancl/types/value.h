@@ -2,6 +2,7 @@
 #ifndef H_PANCL_TYPES_VALUE
 #define H_PANCL_TYPES_VALUE
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "pancl/types/array.h"
@@ -98,16 +99,31 @@ enum pancl_type {
 
 /**
  * Union of data types.
+ *
+ * With PANCL_COMPACT_VALUES arrays, custom types, tables and tuples are
+ * stored out of line.  Use pancl_value_array(), pancl_value_custom(),
+ * pancl_value_table() and pancl_value_tuple() to access them with either
+ * layout.
  */
 union pancl_type_union {
+#if defined(PANCL_COMPACT_VALUES)
+	struct pancl_array *array;        /**< PANCL_TYPE_ARRAY */
+	struct pancl_custom *custom;      /**< PANCL_TYPE_CUSTOM */
+#else
 	struct pancl_array array;         /**< PANCL_TYPE_ARRAY */
 	struct pancl_custom custom;       /**< PANCL_TYPE_CUSTOM */
+#endif
 	int boolean;                      /**< PANCL_TYPE_BOOLEAN */
 	double floating;                  /**< PANCL_TYPE_FLOATING */
 	int_least32_t integer;            /**< PANCL_TYPE_INTEGER */
-	struct pancl_utf8_string *string; /**< PANCL_TYPE_STRING (non-NULL) */
+	pancl_string string;              /**< PANCL_TYPE_STRING (non-NULL) */
+#if defined(PANCL_COMPACT_VALUES)
+	struct pancl_table_data *table;   /**< PANCL_TYPE_TABLE */
+	struct pancl_tuple *tuple;        /**< PANCL_TYPE_TUPLE */
+#else
 	struct pancl_table_data table;    /**< PANCL_TYPE_TABLE */
 	struct pancl_tuple tuple;         /**< PANCL_TYPE_TUPLE */
+#endif
 	union {
 		int_least8_t int8;     /**< PANCL_TYPE_OPT_INT8 */
 		uint_least8_t uint8;   /**< PANCL_TYPE_OPT_UINT8 */
@@ -124,7 +140,9 @@ union pancl_type_union {
  * Represents a value (type and data).
  */
 struct pancl_value {
+#if !defined(PANCL_NO_LOCATIONS)
 	struct pancl_location loc; /**< Where found in the input */
+#endif
 	union pancl_type_union data; /**< The actual data */
 	enum pancl_type type; /**< Type of data this value represents */
 };
@@ -135,8 +153,109 @@ struct pancl_value {
  * @param[in,out] value   Pointer to the pointer to the value to clean up
  *
  * @note The dereference of @p value will be set to NULL on return.
+ * @note
+ *   Parsed values may only be destroyed one at a time (after taking them
+ *   out of their table) if the table's pancl_table.pool is NULL, i.e. it
+ *   was parsed with the library wide allocators and none of
+ *   PANCL_PARSE_ARENA, PANCL_PARSE_RECYCLE and PANCL_PARSE_INTERN_*.
+ *   Otherwise they belong to the table until pancl_table_fini().
+ * @note
+ *   With PANCL_INLINE_CONTAINERS array and tuple values aren't separate
+ *   allocations and can't be destroyed on their own.
  */
 void pancl_value_destroy(struct pancl_value **value);
 
+/**
+ * Retrieves the array of a PANCL_TYPE_ARRAY value, whatever the value
+ * layout.
+ */
+static inline struct pancl_array *
+pancl_value_array(const struct pancl_value *value)
+{
+#if defined(PANCL_COMPACT_VALUES)
+	return value->data.array;
+#else
+	return (struct pancl_array *)&(value->data.array);
+#endif
+}
+
+/**
+ * Retrieves the custom type of a PANCL_TYPE_CUSTOM value, whatever the
+ * value layout.
+ */
+static inline struct pancl_custom *
+pancl_value_custom(const struct pancl_value *value)
+{
+#if defined(PANCL_COMPACT_VALUES)
+	return value->data.custom;
+#else
+	return (struct pancl_custom *)&(value->data.custom);
+#endif
+}
+
+/**
+ * Retrieves the table data of a PANCL_TYPE_TABLE value, whatever the value
+ * layout.
+ */
+static inline struct pancl_table_data *
+pancl_value_table(const struct pancl_value *value)
+{
+#if defined(PANCL_COMPACT_VALUES)
+	return value->data.table;
+#else
+	return (struct pancl_table_data *)&(value->data.table);
+#endif
+}
+
+/**
+ * Retrieves the tuple of a PANCL_TYPE_TUPLE value, whatever the value
+ * layout.
+ */
+static inline struct pancl_tuple *
+pancl_value_tuple(const struct pancl_value *value)
+{
+#if defined(PANCL_COMPACT_VALUES)
+	return value->data.tuple;
+#else
+	return (struct pancl_tuple *)&(value->data.tuple);
+#endif
+}
+
+/**
+ * Retrieves a value of a pancl_array, whatever the container layout.
+ *
+ * @param[in] array   Array to look into
+ * @param[in] index   Index of the value, must be less than array->count
+ *
+ * @return Returns the value at @p index.
+ */
+static inline struct pancl_value *
+pancl_array_at(const struct pancl_array *array, size_t index)
+{
+#if defined(PANCL_INLINE_CONTAINERS)
+	return &(array->values[index]);
+#else
+	return array->values[index];
+#endif
+}
+
+/**
+ * Retrieves a value of a pancl_tuple, whatever the container layout.
+ *
+ * @param[in] tuple   Tuple to look into
+ * @param[in] index   Index of the value, must be less than tuple->count
+ *
+ * @return Returns the value at @p index.
+ */
+static inline struct pancl_value *
+pancl_tuple_at(const struct pancl_tuple *tuple, size_t index)
+{
+#if defined(PANCL_INLINE_CONTAINERS)
+	return &(tuple->values[index]);
+#else
+	return tuple->values[index];
+#endif
+}
+
 #endif /* H_PANCL_TYPES_VALUE */
 // vim:ts=4:sw=4:autoindent
@@ -56,10 +56,19 @@ pancl_strerror(int pancl_error_code)
 	CASE( PANCL_ERROR_, STR_TO_INT_BASE );
 	CASE( PANCL_ERROR_, STR_TO_INT_CHAR );
 	CASE( PANCL_ERROR_, STR_TO_INT_RANGE );
+	/* String to Floating point */
+	CASE( PANCL_ERROR_, STR_TO_FLOAT_CHAR );
+	CASE( PANCL_ERROR_, STR_TO_FLOAT_OVERFLOW );
+	CASE( PANCL_ERROR_, STR_TO_FLOAT_UNDERFLOW );
+	CASE( PANCL_ERROR_, STR_TO_FLOAT_BASE );
 	/* Optional integer types */
 	CASE( PANCL_ERROR_, OPT_INT_ARG_COUNT );
 	CASE( PANCL_ERROR_, OPT_INT_ARG_0_NOT_STRING );
 	CASE( PANCL_ERROR_, OPT_INT_ARG_1_NOT_INT );
+	/* Optional floating point type */
+	CASE( PANCL_ERROR_, OPT_FLOAT_ARG_COUNT );
+	CASE( PANCL_ERROR_, OPT_FLOAT_ARG_0_NOT_STRING );
+	CASE( PANCL_ERROR_, OPT_FLOAT_ARG_1_NOT_INT );
 
 	default:
 		return "(UNKNOWN ERROR)";
@@ -43,38 +43,104 @@ struct pancl_parse_operations {
 	void (*fini)(void *ops_data);
 };
 
+/**
+ * Bytes at the front of the read buffer that are never read into.  The
+ * start of a codepoint cut off by the end of the buffer is moved there, right
+ * in front of the rest of it, so nothing else ever has to be copied.  Lead
+ * bytes claim sequences of up to 6 bytes (decode_utf8() rejects the longer
+ * ones), so at most 5 bytes are kept.  pancl_context.buffer_size includes
+ * it.
+ */
+#define REFILL_HEADROOM  (8)
+
 /* types/array.c */
 void pancl_array_init(struct pancl_array *array);
-void pancl_array_fini(struct pancl_array *array);
-int pancl_array_append(struct pancl_array *array, struct pancl_value *value);
+void pancl_array_fini(struct pancl_pool *pool, struct pancl_array *array);
+int pancl_array_append(struct pancl_pool *pool, struct pancl_array *array,
+		struct pancl_value *value);
+int pancl_array_reserve(struct pancl_pool *pool, struct pancl_array *array,
+		size_t capacity);
+int pancl_array_shrink_to_fit(struct pancl_pool *pool,
+		struct pancl_array *array);
 
 /* types/tuple.c */
 void pancl_tuple_init(struct pancl_tuple *tuple);
-void pancl_tuple_fini(struct pancl_tuple *tuple);
-int pancl_tuple_append(struct pancl_tuple *tuple, struct pancl_value *value);
+void pancl_tuple_fini(struct pancl_pool *pool, struct pancl_tuple *tuple);
+int pancl_tuple_append(struct pancl_pool *pool, struct pancl_tuple *tuple,
+		struct pancl_value *value);
+int pancl_tuple_reserve(struct pancl_pool *pool, struct pancl_tuple *tuple,
+		size_t capacity);
+int pancl_tuple_shrink_to_fit(struct pancl_pool *pool,
+		struct pancl_tuple *tuple);
 
 /* types/custom.c */
 void pancl_custom_init(struct pancl_custom *custom);
-void pancl_custom_fini(struct pancl_custom *custom);
+void pancl_custom_fini(struct pancl_pool *pool, struct pancl_custom *custom);
 
 /* types/table_data.c */
 void pancl_table_data_init(struct pancl_table_data *td);
-void pancl_table_data_fini(struct pancl_table_data *td);
-int pancl_table_data_append(struct pancl_table_data *td,
-		struct pancl_entry *entry);
+void pancl_table_data_fini(struct pancl_pool *pool,
+		struct pancl_table_data *td);
+int pancl_table_data_append(struct pancl_pool *pool,
+		struct pancl_table_data *td, struct pancl_entry *entry);
+int pancl_table_data_reserve(struct pancl_pool *pool,
+		struct pancl_table_data *td, size_t capacity);
+int pancl_table_data_shrink_to_fit(struct pancl_pool *pool,
+		struct pancl_table_data *td);
 
 /* types/utf8_string.c */
-int pancl_utf8_string_new(struct pancl_utf8_string **string, size_t bytes);
+int pancl_utf8_string_new(struct pancl_pool *pool,
+		struct pancl_utf8_string **string, size_t bytes);
+/* Kinds of strings in parsed data, as the PANCL_PARSE_INTERN_* flag that
+ * applies to them.
+ */
+#define STRING_KEY    PANCL_PARSE_INTERN_KEYS
+#define STRING_VALUE  PANCL_PARSE_INTERN_STRINGS
+
+int pancl_string_take(struct pancl_pool *pool, unsigned int kind,
+		pancl_string *dest, struct pancl_utf8_string **src);
+int pancl_string_copy(struct pancl_pool *pool, unsigned int kind,
+		pancl_string *dest, const char *data, size_t bytes,
+		size_t codepoints);
+void pancl_string_release(struct pancl_pool *pool, unsigned int kind,
+		pancl_string *string);
+void pancl_utf8_string_release(struct pancl_pool *pool,
+		struct pancl_utf8_string **string);
 
 /* types/value.c */
-int pancl_value_new(struct pancl_value **value, enum pancl_type type);
+int pancl_value_new(struct pancl_pool *pool, struct pancl_value **value,
+		enum pancl_type type);
 void pancl_value_init(struct pancl_value *value, enum pancl_type type);
-void pancl_value_fini(struct pancl_value *value);
+int pancl_value_init_data(struct pancl_pool *pool, struct pancl_value *value,
+		enum pancl_type type);
+void pancl_value_fini(struct pancl_pool *pool, struct pancl_value *value);
+void pancl_value_fini_data(struct pancl_pool *pool, struct pancl_value *value);
+void pancl_value_release(struct pancl_pool *pool, struct pancl_value **value);
+int pancl_value_shrink_to_fit(struct pancl_pool *pool,
+		struct pancl_value *value);
 
 /* types/entry.c */
-int pancl_entry_new(struct pancl_entry **entry);
+int pancl_entry_new(struct pancl_pool *pool, struct pancl_entry **entry);
 void pancl_entry_init(struct pancl_entry *entry);
-void pancl_entry_fini(struct pancl_entry *entry);
+void pancl_entry_fini(struct pancl_pool *pool, struct pancl_entry *entry);
+void pancl_entry_release(struct pancl_pool *pool, struct pancl_entry **entry);
+
+/* pancl.c */
+void pancl_context_clear_error(struct pancl_context *ctx);
+
+/**
+ * Whether tokens and parsed nodes get their locations filled in.
+ */
+static inline bool
+context_tracks_locations(const struct pancl_context *ctx)
+{
+#if defined(PANCL_NO_LOCATIONS)
+	(void)ctx;
+	return false;
+#else
+	return (ctx->flags & PANCL_PARSE_NO_LOCATIONS) == 0;
+#endif
+}
 
 /* overflow.c */
 int safe_add(size_t a, size_t b, size_t *r);
@@ -86,12 +152,59 @@ can_inc(size_t v)
 	return (v != SIZE_MAX);
 }
 
+/**
+ * Next capacity for a container that ran out of room.  Growing geometrically
+ * keeps appends amortized O(1).
+ */
+static inline size_t
+grow_capacity(size_t capacity)
+{
+	if (capacity < 4)
+		return 4;
+
+	if (capacity > SIZE_MAX / 2)
+		return SIZE_MAX;
+
+	return capacity * 2;
+}
+
 /* memory.c */
 void pancl_free(void *p);
 void *pancl_alloc(size_t n);
 void *pancl_zalloc(size_t n);
 void *pancl_realloc(void *p, size_t n);
-int pancl_resize(void **p, size_t n, size_t count);
+/* A NULL allocator (or one without callbacks) means the library defaults. */
+void *pancl_allocator_alloc(const struct pancl_allocator *allocator,
+		size_t n);
+void *pancl_allocator_realloc(const struct pancl_allocator *allocator,
+		void *p, size_t old_size, size_t n);
+void pancl_allocator_free(const struct pancl_allocator *allocator, void *p,
+		size_t size);
+bool pancl_allocator_is_default(const struct pancl_allocator *allocator);
+int pancl_resize(const struct pancl_allocator *allocator, void **p, size_t n,
+		size_t old_count, size_t count);
+
+/* pool.c
+ *
+ * A NULL pool is valid everywhere and means "plain heap allocations" with
+ * the library defaults.
+ */
+int pancl_pool_new(struct pancl_pool **pool,
+		const struct pancl_allocator *allocator, unsigned int flags);
+struct pancl_pool *pancl_pool_ref(struct pancl_pool *pool);
+void pancl_pool_unref(struct pancl_pool **pool);
+bool pancl_pool_is_shared(const struct pancl_pool *pool);
+bool pancl_pool_is_arena(const struct pancl_pool *pool);
+bool pancl_pool_is_plain(const struct pancl_pool *pool);
+bool pancl_pool_interns(const struct pancl_pool *pool, unsigned int kind);
+int pancl_pool_intern(struct pancl_pool *pool, const char *data,
+		size_t bytes, size_t codepoints, struct pancl_utf8_string **string);
+void pancl_pool_reset(struct pancl_pool *pool);
+void *pancl_pool_alloc(struct pancl_pool *pool, size_t n);
+void *pancl_pool_zalloc(struct pancl_pool *pool, size_t n);
+void pancl_pool_free(struct pancl_pool *pool, void *p, size_t size);
+int pancl_pool_resize(struct pancl_pool *pool, void **p, size_t n,
+		size_t old_count, size_t count);
 
 #endif /* H_PANCL_INTERNAL */
 // vim:ts=4:sw=4:autoindent
@@ -11,12 +11,64 @@
 #include "pancl/pancl.h"
 
 #include "lexer/numeric.h"
+#include "lexer/scan.h"
 #include "lexer/token.h"
 #include "lexer/utf8.h"
 
+/**
+ * Brings ctx->loc up to @p p in the current buffer.
+ *
+ * Only newlines update ctx->loc while lexing, so the column and offset stay
+ * those of ctx->loc_cursor until something asks for a location.  Counting
+ * the codepoints since then is a single vectorized pass, and every byte is
+ * counted at most once.
+ */
+static void
+update_location(struct pancl_context *ctx, const char *p)
+{
+	ctx->loc.column += (uint_least32_t)scan_codepoints(ctx->loc_cursor, p);
+	ctx->loc.offset += (size_t)(p - ctx->loc_cursor);
+	ctx->loc_cursor = p;
+}
+
+/**
+ * Byte offset of the cursor in the input, without counting columns.
+ */
+static size_t
+cursor_offset(const struct pancl_context *ctx)
+{
+	return ctx->loc.offset + (size_t)(ctx->cursor - ctx->loc_cursor);
+}
+
+/**
+ * Location of the cursor: the line, and the column of the next codepoint.
+ */
+struct pancl_location
+lexer_location(struct pancl_context *ctx)
+{
+	update_location(ctx, ctx->cursor);
+	return ctx->loc;
+}
+
+/**
+ * Starts a new line at the cursor.
+ */
+static void
+newline_location(struct pancl_context *ctx)
+{
+	ctx->loc.offset = cursor_offset(ctx);
+	ctx->loc.column = 0;
+	ctx->loc.line += 1;
+	ctx->loc_cursor = ctx->cursor;
+}
+
 /**
  * Attempts to refill the input buffer.
  *
+ * Tokens never point into the read buffer (see input_is_stable()), so a
+ * token split by a refill is already complete up to the cursor and only the
+ * bytes at the cursor itself have to survive it.
+ *
  * @param[in] need
  *   At least this many characters must be in the buffer.
  *   When this is non-zero we also retain whatever content is left in the
@@ -26,9 +78,10 @@ static int
 refill(struct pancl_context *ctx, size_t need)
 {
 	int err;
-	size_t retained = 0;
-	size_t size = ctx->buffer_size;
-	char *start = ctx->allocated_buffer;
+	size_t size;
+	size_t kept = 0;
+	char *start = (char *)ctx->allocated_buffer + REFILL_HEADROOM;
+	char *end;
 
 	if (ctx->end_of_input || ctx->allocated_buffer == NULL) {
 		/* If bytes were requested then we need to return a truncated UTF-8
@@ -37,49 +90,56 @@ refill(struct pancl_context *ctx, size_t need)
 		return (need != 0) ? PANCL_ERROR_UTF8_TRUNC : PANCL_END_OF_INPUT;
 	}
 
-	/* If requested, we retain the remaining characters in the buffer before
-	 * refilling.
-	 */
-	if (need != 0) {
-		start = ctx->allocated_buffer;
+	/* The consumed part of the buffer is about to go away. */
+	update_location(ctx, ctx->cursor);
 
-		for (; ctx->cursor <= ctx->end; ++start) {
-			*start = *(ctx->cursor);
-			++retained;
-		}
+	if (need != 0) {
+		kept = (size_t)(ctx->end - ctx->cursor);
+		memmove(start - kept, ctx->cursor, kept);
+	}
 
-		/* Simplify the logic so we can just check against 'size' later on. */
-		if (retained > need)
-			need = 0;
-		else
-			need -= retained;
+	ctx->cursor = start - kept;
+	ctx->loc_cursor = ctx->cursor;
+	end = start;
 
-		size -= retained;
-	}
+	/* Short reads are fine, unless they leave the codepoint incomplete. */
+	do {
+		size = ctx->buffer_size - REFILL_HEADROOM - (size_t)(end - start);
+		err = ctx->ops->next(ctx->ops_data, end, &size);
 
-	err = ctx->ops->next(ctx->ops_data, start, &size);
+		if (err != 0) {
+			ctx->end = end;
+			return PANCL_ERROR_LEXER_REFILL;
+		}
 
-	if (err != 0)
-		return PANCL_ERROR_LEXER_REFILL;
+		/* No more data? End of input. */
+		if (size == 0)
+			ctx->end_of_input = 1;
 
-	/* Reset cursor to the entire buffer not the location we started
-	 * refilling at.
-	 */
-	ctx->cursor = ctx->allocated_buffer;
-	ctx->end = ctx->cursor + size + retained;
+		end += size;
+	} while (size != 0 && (size_t)(end - ctx->cursor) < need);
 
-	/* No more data? End of input. */
-	if (size == 0)
-		ctx->end_of_input = 1;
+	ctx->end = end;
 
-	/* If we read less than the number we needed it's a truncated UTF-8
-	 * character sequence.
+	/* If we have less than we needed it's a truncated UTF-8 character
+	 * sequence.
 	 */
-	if (size < need)
+	if ((size_t)(ctx->end - ctx->cursor) < need)
 		return PANCL_ERROR_UTF8_TRUNC;
 
-	/* Only return SUCCESS if we didn't encounter the end of input. */
-	return (ctx->end_of_input) ? PANCL_END_OF_INPUT : PANCL_SUCCESS;
+	/* Only return END_OF_INPUT if nothing at all was left. */
+	return (ctx->cursor == ctx->end) ? PANCL_END_OF_INPUT : PANCL_SUCCESS;
+}
+
+/**
+ * Checks if the entire input stays in memory while parsing, in which case
+ * tokens can borrow their text from it instead of copying it.  That is the
+ * case for pancl_parse_buffer() and pancl_parse_string().
+ */
+static bool
+input_is_stable(const struct pancl_context *ctx)
+{
+	return ctx->allocated_buffer == NULL;
 }
 
 /**
@@ -91,6 +151,18 @@ peek_next(struct pancl_context *ctx, uint_fast32_t *p)
 	int err;
 	size_t need;
 
+	/* ASCII needs neither a refill nor decoding. */
+	if (ctx->cursor < ctx->end && (unsigned char)*(ctx->cursor) < 0x80) {
+		*p = (unsigned char)*(ctx->cursor);
+		return PANCL_SUCCESS;
+	}
+
+	/* Validated input only holds complete and valid sequences. */
+	if (ctx->input_valid && ctx->cursor < ctx->end) {
+		(void)decode_utf8_valid((const unsigned char *)(ctx->cursor), p);
+		return PANCL_SUCCESS;
+	}
+
 	if (ctx->cursor >= ctx->end) {
 		err = refill(ctx, 0);
 
@@ -130,19 +202,34 @@ advance(struct pancl_context *ctx)
 {
 	int err;
 	size_t length;
-	uint_fast32_t c;
+	uint_fast32_t c = (unsigned char)*(ctx->cursor);
+
+	/* ASCII other than CR and LF is by far the most common case and needs
+	 * neither decoding nor line tracking.
+	 */
+	if (c < 0x80 && c != '\r' && c != '\n') {
+		ctx->cursor += 1;
+		return PANCL_SUCCESS;
+	}
 
 	/* This should only be used AFTER a peek so we optimize and don't perform
 	 * any safety checks as it should be valid.
 	 */
-	length = utf8_length_c(*(ctx->cursor));
-	err = decode_utf8((unsigned char *)(ctx->cursor), &c);
+	if (c < 0x80) {
+		length = 1;
+	}
+	else if (ctx->input_valid) {
+		length = decode_utf8_valid((const unsigned char *)(ctx->cursor), &c);
+	}
+	else {
+		length = utf8_length_c(*(ctx->cursor));
+		err = decode_utf8((unsigned char *)(ctx->cursor), &c);
 
-	if (err != PANCL_SUCCESS)
-		return err;
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
 
 	ctx->cursor += length;
-	ctx->loc.column += 1;
 
 	switch (c) {
 	case '\r':
@@ -157,14 +244,12 @@ advance(struct pancl_context *ctx)
 			 * If we got CR LF, wait to increment the line count until we
 			 * consume the LF.
 			 */
-			ctx->loc.column = 0;
-			ctx->loc.line += 1;
+			newline_location(ctx);
 		}
 		break;
 
 	case '\n':
-		ctx->loc.column = 0;
-		ctx->loc.line += 1;
+		newline_location(ctx);
 		break;
 	}
 
@@ -236,7 +321,22 @@ consume_comment(struct pancl_context *ctx)
 	bool escape = false;
 
 	/* Eat everything up-to and including the newline. */
-	while ((err = get_next(ctx, &c)) == PANCL_SUCCESS) {
+	for (;;) {
+		/* Plain text is skipped in bulk; only its last character matters
+		 * for the escaped newline check.
+		 */
+		size_t n = scan_comment(ctx->cursor, ctx->end);
+
+		if (n != 0) {
+			escape = (ctx->cursor[n - 1] == '\\');
+			ctx->cursor += n;
+		}
+
+		err = get_next(ctx, &c);
+
+		if (err != PANCL_SUCCESS)
+			break;
+
 		if (is_newline(ctx, c)) {
 			/* Escaped newlines are not allowed in a comment. */
 			if (escape)
@@ -256,6 +356,15 @@ is_whitespace(uint_fast32_t c)
 	return (c == ' ' || c == '\t');
 }
 
+/**
+ * Skips the run of whitespace at the cursor, if any.
+ */
+static void
+skip_whitespace(struct pancl_context *ctx)
+{
+	ctx->cursor += scan_whitespace(ctx->cursor, ctx->end);
+}
+
 static bool
 is_raw_ident(uint_fast32_t c)
 {
@@ -276,31 +385,53 @@ get_raw_ident(struct pancl_context *ctx, struct token_buffer *tb,
 {
 	uint_fast32_t p;
 	int err;
+	bool borrow = input_is_stable(ctx);
 
 	token_buffer_reset(tb);
 
-	if (prefix != '\0') {
+	/* Raw identifiers never need any translation, so with a stable input
+	 * the token can simply point at it.  The prefix was consumed already so
+	 * it's the (single) byte just before the cursor.
+	 */
+	if (borrow)
+		token_buffer_borrow(tb, ctx->cursor - ((prefix != '\0') ? 1 : 0));
+
+	if (prefix != '\0' && borrow) {
+		token_buffer_extend(tb, 1, 1);
+	}
+	else if (prefix != '\0') {
 		err = token_buffer_append(tb, prefix);
 
 		if (err != PANCL_SUCCESS)
 			return err;
 	}
 
-	while ((err = peek_next(ctx, &p)) == PANCL_SUCCESS) {
-		/* Not a raw identifier character, must be a boundary? */
-		if (!is_raw_ident(p))
-			return token_buffer_end(tb);
+	/* Raw identifiers are pure ASCII, so whatever is in the buffer can be
+	 * taken in one go.  peek_next() is only needed to refill.
+	 */
+	for (;;) {
+		size_t n = scan_raw_ident(ctx->cursor, ctx->end);
 
-		/* Valid raw identifier character, add to the buffer. */
-		err = token_buffer_append(tb, p);
+		if (borrow)
+			token_buffer_extend(tb, n, n);
+		else if (n != 0)
+			err = token_buffer_append_ascii(tb, ctx->cursor, n);
+		else
+			err = PANCL_SUCCESS;
 
 		if (err != PANCL_SUCCESS)
 			return err;
 
-		err = advance(ctx);
+		ctx->cursor += n;
+
+		err = peek_next(ctx, &p);
 
 		if (err != PANCL_SUCCESS)
 			break;
+
+		/* Not a raw identifier character, must be a boundary. */
+		if (!is_raw_ident(p))
+			return token_buffer_end(tb);
 	}
 
 	/* End of input counts as finishing the identifier. */
@@ -311,77 +442,29 @@ get_raw_ident(struct pancl_context *ctx, struct token_buffer *tb,
 	return err;
 }
 
-/**
- * Checks a string to see if it looks like a numeric token and returns
- * its token type (RAW IDENT returned if not numeric).
- */
-static int
-get_numeric_token_type(const char *str)
-{
-	if (str_is_binary(str, true))
-		return TT_INT_BIN;
-
-	if (str_is_decimal(str))
-		return TT_INT_DEC;
-
-	if (str_is_hexadecimal(str, true))
-		return TT_INT_HEX;
-
-	if (str_is_octal(str, true))
-		return TT_INT_OCT;
-
-	if (str_is_float(str))
-		return TT_FLOAT;
-
-	return TT_RAW_IDENT;
-}
-
 static int
 set_ident_token(struct token *t, struct pancl_context *ctx,
 	struct token_buffer *tb)
 {
 	int type;
+	const char *text = token_buffer_data(tb);
 
 	/* Simple cases: boolean true and false. */
-	if (strcmp(tb->buffer, "true") == 0)
+	if (tb->pos == 4 && memcmp(text, "true", 4) == 0)
 		return token_set_empty(t, TT_TRUE, TST_IDENT);
 
-	if (strcmp(tb->buffer, "false") == 0)
+	if (tb->pos == 5 && memcmp(text, "false", 5) == 0)
 		return token_set_empty(t, TT_FALSE, TST_IDENT);
 
-	/* Numeric regexes:
-	 *  DecInt:  [-+]?(0|[1-9][0-9]*)
-	 *  HexInt:  [-+]?0[xX][a-fA-F0-9]+
-	 *  OctInt:  [-+]?0[oO][0-7]+
-	 *  BinInt:  [-+]?0[bB][0-1]+
-	 *
-	 *  Frac:    ([0-9]*\.[0-9]+)|([0-9]+\.)
-	 *  Exp:     [eE][+-]?[0-9]+
-	 *  Float:   (<Frac><Exp>?)|([0-9]+<Exp>)
-	 *
-	 *  FloatStart:  [0-9.+-]
-	 *  DecStart:    [0-9+-]
-	 *  *Start:      [0+-]
-	 *
-	 *  Special floats:
-	 *    [+-]?Inf
-	 *    [+-]?NaN
+	/* Numbers, including the special floats (Inf, NaN), are classified and
+	 * converted in one go.
 	 */
-
-	/* Check for valid numeric start values. */
-
-	switch (tb->buffer[0]) {
+	switch (text[0]) {
 	case '-': case '+': case '.':
 	case '0': case '1': case '2': case '3': case '4':
 	case '5': case '6': case '7': case '8': case '9':
-		type = get_numeric_token_type(tb->buffer);
-		break;
-	/* Special floats (Inf, NaN). */
 	case 'I': case 'N':
-		if (str_is_float(tb->buffer))
-			type = TT_FLOAT;
-		else
-			type = TT_RAW_IDENT;
+		type = numeric_scan(text, tb->pos, &(t->number));
 		break;
 
 	default:
@@ -389,7 +472,10 @@ set_ident_token(struct token *t, struct pancl_context *ctx,
 		break;
 	}
 
-	return token_set(t, type, TST_IDENT, tb);
+	if (type == TT_RAW_IDENT)
+		return token_set(ctx, t, type, TST_IDENT, tb);
+
+	return token_set_number(ctx, t, type, tb);
 }
 
 
@@ -403,20 +489,19 @@ static int
 handle_octal_escape(struct pancl_context *ctx, struct token_buffer *tb,
 	uint_fast32_t start)
 {
-	int err;
-	int count = 0;
-	uint_fast32_t val = 0;
+	int err = PANCL_SUCCESS;
+	int count = 1;
+	uint_fast32_t val = start - '0';
 
-	uint_fast32_t p = start;
+	uint_fast32_t p;
 
-	do {
+	/* The first digit was consumed along with the slash, so only peek at the
+	 * ones after it: up to 3 digits can be handled.
+	 */
+	while (count < 3 && (err = peek_next(ctx, &p)) == PANCL_SUCCESS) {
 		/* Done parsing the octal */
 		if (p < '0' || p > '7')
-			goto done;
-
-		/* Already have the max digits we can handle. */
-		if (count == 3)
-			goto done;
+			break;
 
 		/* Got an octal digit. */
 		val <<= 3;
@@ -427,13 +512,12 @@ handle_octal_escape(struct pancl_context *ctx, struct token_buffer *tb,
 
 		if (err != PANCL_SUCCESS)
 			break;
-	} while ((err = peek_next(ctx, &p)) == PANCL_SUCCESS);
+	}
 
 	/* We're in an escape sequence, END_OF_INPUT is a bad thing. */
 	if (err != PANCL_SUCCESS)
 		return PANCL_ERROR_STR_SHORT;
 
-done:
 	/* Before we add the number, we have to check the domain. The maximum octal
 	 * we can support is \377 (0xff).
 	 */
@@ -527,7 +611,8 @@ handle_escape(struct pancl_context *ctx, struct token_buffer *tb,
 	int err = PANCL_SUCCESS;
 
 	/* Store error context in case of a failure. */
-	ctx->error_loc = ctx->loc;
+	if (context_tracks_locations(ctx))
+		ctx->error_loc = lexer_location(ctx);
 
 	/* In raw mode, everything is unhandled. */
 	if (raw) {
@@ -584,6 +669,34 @@ handle_escape(struct pancl_context *ctx, struct token_buffer *tb,
 	return PANCL_ERROR_STR_ESC_UNKNOWN;
 }
 
+/**
+ * Consumes the run of plain ASCII string content at the cursor in one go.
+ */
+static int
+take_string_run(struct pancl_context *ctx, struct token_buffer *tb,
+	uint_fast32_t delim, bool borrow)
+{
+	int err;
+	size_t n = scan_string(ctx->cursor, ctx->end, (char)delim);
+
+	if (n == 0)
+		return PANCL_SUCCESS;
+
+	if (borrow) {
+		token_buffer_extend(tb, n, n);
+	}
+	else {
+		err = token_buffer_append_ascii(tb, ctx->cursor, n);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
+
+	ctx->cursor += n;
+
+	return PANCL_SUCCESS;
+}
+
 /**
  * Expects to start just past the delimiter.
  */
@@ -596,13 +709,40 @@ get_single_string(struct pancl_context *ctx, struct token_buffer *tb,
 
 	bool raw = (delim == '\''); /* single-quotes = raw string */
 	bool do_escape = false;
+	/* Until something has to be translated the token can point into a
+	 * stable input.  Adjacent strings are never contiguous so only the first
+	 * one gets to do this.
+	 */
+	bool borrow = input_is_stable(ctx) && tb->pos == 0;
+	const char *at;
+
+	if (borrow)
+		token_buffer_borrow(tb, ctx->cursor);
 
 	/* Starts past the delimiter so we just append to the buffer, handling
 	 * any escape sequences (non-raw) we encounter.
 	 */
 
-	/* We can use get_next() here since we always need to consume. */
-	while ((err = get_next(ctx, &c)) == PANCL_SUCCESS) {
+	for (;;) {
+		/* Plain content is taken in bulk, anything else one codepoint at a
+		 * time.
+		 */
+		if (!do_escape) {
+			err = take_string_run(ctx, tb, delim, borrow);
+
+			if (err != PANCL_SUCCESS) {
+				ctx->error_loc = lexer_location(ctx);
+				return err;
+			}
+		}
+
+		/* We can use get_next() here since we always need to consume. */
+		at = ctx->cursor;
+		err = get_next(ctx, &c);
+
+		if (err != PANCL_SUCCESS)
+			break;
+
 		if (do_escape) {
 			/* handle_escape manages its own error context. */
 			err = handle_escape(ctx, tb, c, raw);
@@ -616,6 +756,7 @@ get_single_string(struct pancl_context *ctx, struct token_buffer *tb,
 
 		if (c == '\\') {
 			do_escape = true;
+			borrow = false;
 			continue;
 		}
 
@@ -624,7 +765,7 @@ get_single_string(struct pancl_context *ctx, struct token_buffer *tb,
 			err = token_buffer_end(tb);
 
 			if (err != PANCL_SUCCESS)
-				ctx->error_loc = ctx->loc;
+				ctx->error_loc = lexer_location(ctx);
 
 			return err;
 		}
@@ -632,18 +773,34 @@ get_single_string(struct pancl_context *ctx, struct token_buffer *tb,
 		/* If we get an embedded newline then we have to canonicalize it to
 		 * a single LF character.
 		 */
-		if (is_newline(ctx, c))
+		if (is_newline(ctx, c)) {
+			/* A lone LF is already canonical. */
+			if (c != '\n')
+				borrow = false;
+
 			c = '\n';
+		}
+
+		/* Overlong sequences decode to a shorter one, which is what a file
+		 * would store too.
+		 */
+		if (borrow && utf8_length(c) != (size_t)(ctx->cursor - at))
+			borrow = false;
+
+		if (borrow) {
+			token_buffer_extend(tb, (size_t)(ctx->cursor - at), 1);
+			continue;
+		}
 
 		err = token_buffer_append(tb, c);
 
 		if (err != PANCL_SUCCESS) {
-			ctx->error_loc = ctx->loc;
+			ctx->error_loc = lexer_location(ctx);
 			return err;
 		}
 	}
 
-	ctx->error_loc = ctx->loc;
+	ctx->error_loc = lexer_location(ctx);
 
 	/* If END_OF_INPUT then we ran out of content before finding the ending
 	 * delimiter.
@@ -657,10 +814,14 @@ get_single_string(struct pancl_context *ctx, struct token_buffer *tb,
 
 /**
  * Expects to start just past the delimiter.
+ *
+ * @param[out] end
+ *   Offset just past the closing delimiter of the last adjacent string, as
+ *   the whitespace after it is consumed too.
  */
 static int
 get_string(struct pancl_context *ctx, struct token_buffer *tb,
-	uint_fast32_t delim)
+	uint_fast32_t delim, size_t *end)
 {
 	int err;
 	uint_fast32_t c;
@@ -671,6 +832,8 @@ get_string(struct pancl_context *ctx, struct token_buffer *tb,
 	if (err != PANCL_SUCCESS)
 		return err;
 
+	*end = cursor_offset(ctx);
+
 	/* Okay, we've gotten one string, BUT! strings can be adjacent to one
 	 * another meaning we have to handle the following:
 	 *
@@ -691,6 +854,7 @@ get_string(struct pancl_context *ctx, struct token_buffer *tb,
 			if (err != PANCL_SUCCESS)
 				break;
 
+			skip_whitespace(ctx);
 			continue;
 		}
 
@@ -704,6 +868,7 @@ get_string(struct pancl_context *ctx, struct token_buffer *tb,
 			if (err != PANCL_SUCCESS)
 				break;
 
+			*end = cursor_offset(ctx);
 			continue;
 		}
 
@@ -757,6 +922,8 @@ next_token(struct pancl_context *ctx, struct token_buffer *tb, struct token *t)
 	int err;
 	uint_fast32_t c = '\0';
 	bool escaped = false;
+	bool track = context_tracks_locations(ctx);
+	size_t end;
 
 	/* There's a "small" hack in place for rewinding the lexer by 1 token;
 	 * we deal with that here.
@@ -774,21 +941,63 @@ next_token(struct pancl_context *ctx, struct token_buffer *tb, struct token *t)
 	token_buffer_reset(tb);
 
 	while ((err = get_next(ctx, &c)) == PANCL_SUCCESS) {
-		/* Store position data. */
-		t->loc = ctx->loc;
-		ctx->error_loc = ctx->loc;
-
 		/* Grab newline */
-		if (is_newline(ctx, c)) {
+		if (is_newline_start(ctx, c)) {
+			/* Its location is that of the CR or LF, not of whatever
+			 * follows the sequence.
+			 */
+			struct pancl_location loc = ctx->loc;
+
+			if (track)
+				loc = lexer_location(ctx);
+
+			(void)is_newline(ctx, c);
+
 			/* Escaped newlines are eaten and ignored. */
 			if (escaped) {
 				escaped = false;
 				continue;
 			}
 
+			/* The CR or LF was consumed already, and an LF after a CR was
+			 * just now.
+			 */
+			if (track) {
+				loc.offset -= 1;
+				loc.length = cursor_offset(ctx) - loc.offset;
+				t->loc = loc;
+				ctx->error_loc = loc;
+			}
+
 			return token_set_empty(t, TT_NEWLINE, TST_NEWLINE);
 		}
 
+		/* Whitespace is irrelevant. If found, consume it and start parsing the
+		 * next character.
+		 */
+		if (!escaped && is_whitespace(c)) {
+			skip_whitespace(ctx);
+			continue;
+		}
+
+		/* If we got a backslash then we expect an escaped newline next so mark
+		 * that we're escaping and continue.
+		 */
+		if (!escaped && c == '\\') {
+			escaped = true;
+			continue;
+		}
+
+		/* Everything else is (the start of) a token.  Its first character,
+		 * and the backslash before an escaped one, were consumed already.
+		 */
+		if (track) {
+			t->loc = lexer_location(ctx);
+			t->loc.offset -= utf8_length(c) + (escaped ? 1 : 0);
+			t->loc.length = cursor_offset(ctx) - t->loc.offset;
+			ctx->error_loc = t->loc;
+		}
+
 		/* Anything preceeded by a backslash that isn't a newline is an
 		 * ERROR token.
 		 */
@@ -816,16 +1025,13 @@ next_token(struct pancl_context *ctx, struct token_buffer *tb, struct token *t)
 			break;
 		}
 
-		/* Whitespace is irrelevant. If found, consume it and start parsing the
-		 * next character.
-		 */
-		if (is_whitespace(c))
-			continue;
-
 		/* Comment! (They count as newlines for simplicity) */
 		if (c == '#') {
 			err = consume_comment(ctx);
 
+			if (track)
+				t->loc.length = cursor_offset(ctx) - t->loc.offset;
+
 			if (err == PANCL_SUCCESS)
 				err = token_set_empty(t, TT_COMMENT, TST_NEWLINE);
 
@@ -834,10 +1040,14 @@ next_token(struct pancl_context *ctx, struct token_buffer *tb, struct token *t)
 
 		/* Check for a string. */
 		if (is_quote(c)) {
-			err = get_string(ctx, tb, c);
+			err = get_string(ctx, tb, c, &end);
 
-			if (err == PANCL_SUCCESS)
-				err = token_set(t, TT_STRING, TST_IDENT, tb);
+			if (err == PANCL_SUCCESS) {
+				if (track)
+					t->loc.length = end - t->loc.offset;
+
+				err = token_set(ctx, t, TT_STRING, TST_IDENT, tb);
+			}
 
 			return err;
 		}
@@ -846,6 +1056,9 @@ next_token(struct pancl_context *ctx, struct token_buffer *tb, struct token *t)
 		if (is_raw_ident(c)) {
 			err = get_raw_ident(ctx, tb, c);
 
+			if (track)
+				t->loc.length = cursor_offset(ctx) - t->loc.offset;
+
 			/* Raw identifiers have to be checked again as the following also
 			 * look like raw identifiers:
 			 *   - booleans (true/false)
@@ -858,23 +1071,23 @@ next_token(struct pancl_context *ctx, struct token_buffer *tb, struct token *t)
 			return err;
 		}
 
-		/* If we got a backslash then we expect an escaped newline next so mark
-		 * that we're escaping and continue.
-		 */
-		if (c == '\\') {
-			escaped = true;
-			continue;
-		}
-
 		/* All other characters are invalid. */
 		goto invalid_character;
 	}
 
+	/* Whatever ended the loop is at the cursor. */
+	ctx->error_loc = lexer_location(ctx);
+
 	/* Return end of file (end of input really). */
 	if (err == PANCL_END_OF_INPUT) {
+		t->loc = ctx->error_loc;
+
 		/* If we ended on an a backslash, we need to report it. */
-		if (escaped == true)
+		if (escaped == true) {
+			t->loc.offset -= 1;
+			t->loc.length = 1;
 			goto invalid_character;
+		}
 
 		return token_set_empty(t, TT_EOF, TST_NONE);
 	}
@@ -888,7 +1101,7 @@ invalid_character:
 		err = token_buffer_end(tb);
 
 	if (err == PANCL_SUCCESS)
-		err = token_set(t, TT_ERROR, TST_NONE, tb);
+		err = token_set(ctx, t, TT_ERROR, TST_NONE, tb);
 
 	return err;
 }
@@ -897,7 +1110,7 @@ int
 lexer_rewind_token(struct pancl_context *ctx, struct token *t)
 {
 	if (ctx->token1 == NULL) {
-		ctx->token1 = pancl_alloc(sizeof(*t));
+		ctx->token1 = pancl_allocator_alloc(&(ctx->allocator), sizeof(*t));
 
 		if (ctx->token1 == NULL)
 			return PANCL_ERROR_ALLOC;
@@ -905,7 +1118,7 @@ lexer_rewind_token(struct pancl_context *ctx, struct token *t)
 		token_init(ctx->token1);
 	}
 	else {
-		token_fini(ctx->token1);
+		token_fini(ctx, ctx->token1);
 	}
 
 	token_move(ctx->token1, t);
@@ -1,255 +1,188 @@
 /* SPDX-License-Identifier: MIT */
 #include <stdbool.h>
 #include <stddef.h>
-#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "pancl/pancl.h"
 #include "lexer/token.h"
 #include "lexer/numeric.h"
+#include "parser/str_to_float.h"
 
-bool
-str_is_float(const char *str)
+/**
+ * Value of @p c as a digit in @p base, or -1.
+ */
+static int
+digit_value(char c, int base)
 {
-	bool got_whole = false;
-	bool got_dot = false;
-	bool got_frac = false;
-	bool got_exp = false;
-
-	/* Floating point number break down:
-	 *
-	 *   Whole number, no fraction not exponent:
-	 *     [-+]?[0-9]+.
-	 *   Decimal number, no exponent:
-	 *     [-+]?[0-9]+\.[0-9]+
-	 *   Fraction only, no whole number nor exponent:
-	 *     [-+]?\.[0-9]+
-	 *   Whole number with exponent, no fraction:
-	 *     [-+]?[0-9]+[eE][-+]?[0-9]+
-	 *
-	 *   Optional Exponent (may be attached to any of the above):
-	 *     [eE][-+]?[0-9]+
-	 *
-	 * These are also valid:
-	 *  [-+]?NaN
-	 *  [-+]?Inf
-	 */
-
-	/* Optional starting sign. */
-	if (*str == '-' || *str == '+')
-		++str;
-
-	/* Not-a-number and Infinity checks. */
-	if (strcmp(str, "NaN") == 0 || strcmp(str, "Inf") == 0)
-		return true;
-
-	/* Start with whole number portion.
-	 *  [0-9]*
-	 */
-	for (; *str != '\0'; ++str) {
-		if (*str == '.') {
-			got_dot = true;
-			++str;
-			goto fraction;
-		}
-
-		if (*str == 'e' || *str == 'E') {
-			++str;
-			goto exponent;
-		}
-
-		if (*str < '0' || *str > '9')
-			return false;
+	int v;
+
+	if (c >= '0' && c <= '9')
+		v = c - '0';
+	else if (c >= 'a' && c <= 'f')
+		v = c - 'a' + 10;
+	else if (c >= 'A' && c <= 'F')
+		v = c - 'A' + 10;
+	else
+		return -1;
+
+	return (v < base) ? v : -1;
+}
 
-		got_whole = true;
+/**
+ * Classifies the text of a raw identifier as a number and, for integers,
+ * converts it at the same time.
+ *
+ * Numeric regexes:
+ *  DecInt:  [-+]?(0|[1-9][0-9]*)
+ *  HexInt:  [-+]?0[xX][a-fA-F0-9]+
+ *  OctInt:  [-+]?0[oO][0-7]+
+ *  BinInt:  [-+]?0[bB][0-1]+
+ *
+ *  Frac:    ([0-9]*\.[0-9]+)|([0-9]+\.)
+ *  Exp:     [eE][+-]?[0-9]+
+ *  Float:   (<Frac><Exp>?)|([0-9]+<Exp>)
+ *
+ *  Special floats:
+ *    [-+]?Inf
+ *    [-+]?NaN
+ *
+ * The lexer is a little more lenient than that: a lone sign, leading zeros
+ * and prefixes without digits are numbers as well.  As names they're fine;
+ * as values they're errors (or 0 for bare prefixes), which are stored in
+ * @p number for the parser to report.  Integers take the range of
+ * str_to_int32(), floats that of str_to_double().
+ *
+ * @param[in] str      Text of the token (not necessarily NUL-terminated)
+ * @param[in] len      Length of @p str in bytes
+ * @param[out] number  Value of the token (or the error converting it)
+ *
+ * @return Returns the token type: TT_INT_*, TT_FLOAT or TT_RAW_IDENT.
+ */
+int
+numeric_scan(const char *str, size_t len, struct token_number *number)
+{
+	const char *p = str;
+	const char *end = str + len;
+	const char *digits;
+	bool negative = false;
+	bool whole;
+	bool dot = false;
+	bool frac = false;
+	bool exp = false;
+	int type = TT_INT_DEC;
+	int base = 10;
+	uint_fast64_t r = 0;
+	uint_fast64_t max;
+
+	number->error = PANCL_SUCCESS;
+	number->value.integer = 0;
+
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
 	}
 
-done:
-	/* Validate we have the correct parts for a float. */
-
-	if (got_whole && got_dot)
-		return true;
-
-	if (got_dot && got_frac)
-		return true;
-
-	if (got_whole && got_exp)
-		return true;
-
-	/* Turns out we don't care if we got an exponent or not outside of the
-	 * "just whole number".  In all other cases we just need to validate that
-	 * [eE][+-]? was followed by a series of digits.  That was validated in the
-	 * 'exponent' portion so we don't need re-validate it here.
-	 */
-
-	return false;
+	/* Just a sign. */
+	if (p == end) {
+		number->error = PANCL_ERROR_ARG_INVALID;
+		return TT_INT_DEC;
+	}
 
-fraction:
-	/* Fraction portion (just past '.')
-	 *  \.[0-9]*
-	 */
-	for (; *str != '\0'; ++str) {
-		if (*str == 'e' || *str == 'E') {
-			++str;
-			goto exponent;
+	if (end - p == 3 && (memcmp(p, "Inf", 3) == 0
+			|| memcmp(p, "NaN", 3) == 0))
+		goto floating;
+
+	/* Prefixed integers. */
+	if (p[0] == '0' && end - p >= 2) {
+		switch (p[1]) {
+		case 'b': case 'B':
+			type = TT_INT_BIN;
+			base = 2;
+			break;
+		case 'o': case 'O':
+			type = TT_INT_OCT;
+			base = 8;
+			break;
+		case 'x': case 'X':
+			type = TT_INT_HEX;
+			base = 16;
+			break;
+		default:
+			break;
 		}
 
-		if (*str < '0' || *str > '9')
-			return false;
-
-		got_frac = true;
+		if (base != 10)
+			p += 2;
 	}
 
-	goto done;
+	/* Same limits as str_to_int32(). */
+	max = negative ? (uint_fast64_t)INT32_MAX + 1 : UINT32_MAX;
 
-exponent:
-	/* Exponent (just past 'e' or 'E')
-	 *   [eE][-+]?[0-9]+
+	/* Whole number (or prefixed) digits, converted as they go by.  r stays
+	 * well within 64 bits as it stops growing once past max.
 	 */
-	if (*str == '-' || *str == '+')
-		++str;
+	for (digits = p; p < end; ++p) {
+		int v = digit_value(*p, base);
 
-	/* Must be followed by at least one digit. */
-	if (*str == '\0')
-		return false;
+		if (v < 0)
+			break;
 
-	for (; *str != '\0'; ++str) {
-		if (*str < '0' || *str > '9')
-			return false;
-		got_exp = true;
+		if (r <= max)
+			r = r * (uint_fast64_t)base + (uint_fast64_t)v;
 	}
 
-	goto done;
-}
-
-/* TODO: This is the quick-and-dirty float check that is guaranteed to work.
- * Leaving this here until we validate the above float check.
- */
-#if 0
-bool
-str_is_float(const char *str)
-{
-	size_t s;
-	char *end = NULL;
-
-	if (*str == '-' || *str == '+')
-		++str;
-
-	if (strcmp(str, "NaN") == 0 || strcmp(str, "Inf") == 0)
-		return true;
-
-	/* Since Inf and NaN were already taken care of, this is all we need
-	 * to validate against.
-	 */
-	s = strspn(str, "0123456789eE+-.");
-
-	if (s != strlen(str))
-		return false;
-
-	(void)strtod(str, &end);
-
-	if (end != NULL && *end != '\0')
-		return false;
-
-	/* Domain check is saved for later. */
-	return true;
-}
-#endif
-
-bool
-str_is_binary(const char *str, bool check_prefix)
-{
-	if (*str == '-' || *str == '+')
-		++str;
-
-	/* If checking the prefix, we need to look for '0b' or '0B' */
-	if (check_prefix) {
-		if (str[0] != '0')
-			return false;
-
-		if (str[1] != 'b' && str[1] != 'B')
-			return false;
-
-		str += 2;
+	if (p == end) {
+		if (type == TT_INT_DEC && p - digits > 1 && digits[0] == '0')
+			number->error = PANCL_ERROR_INT_LEADING_ZEROS;
+		else if (r > max)
+			number->error = PANCL_ERROR_STR_TO_INT_RANGE;
+		else if (negative)
+			number->value.integer = (int_least32_t)-(int_fast64_t)r;
+		else
+			number->value.integer = (int_least32_t)r;
+
+		return type;
 	}
 
-	/* Validate the digits. */
-	for (; *str != '\0'; ++str) {
-		if (*str < '0' || *str > '1')
-			return false;
-	}
+	/* Anything else after a prefix isn't a number. */
+	if (type != TT_INT_DEC)
+		return TT_RAW_IDENT;
 
-	return true;
-}
+	whole = (p != digits);
 
-bool
-str_is_decimal(const char *str)
-{
-	if (*str == '-' || *str == '+')
-		++str;
+	/* Fraction: \.[0-9]* */
+	if (*p == '.') {
+		dot = true;
 
-	for (; *str != '\0'; ++str) {
-		if (*str < '0' || *str > '9')
-			return false;
+		for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+			frac = true;
 	}
 
-	return true;
-}
-
-bool
-str_is_hexadecimal(const char *str, bool check_prefix)
-{
-	if (*str == '-' || *str == '+')
-		++str;
+	/* Exponent: [eE][-+]?[0-9]+ */
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		++p;
 
-	/* If checking the prefix, we need to look for '0x' or '0X' */
-	if (check_prefix) {
-		if (str[0] != '0')
-			return false;
+		if (p < end && (*p == '-' || *p == '+'))
+			++p;
 
-		if (str[1] != 'x' && str[1] != 'X')
-			return false;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p)
+			exp = true;
 
-		str += 2;
+		/* Must be followed by at least one digit. */
+		if (!exp)
+			return TT_RAW_IDENT;
 	}
 
-	for (; *str != '\0'; ++str) {
-		if (*str >= '0' && *str <= '9')
-			continue;
-		if (*str >= 'a' && *str <= 'f')
-			continue;
-		if (*str >= 'A' && *str <= 'F')
-			continue;
-
-		return false;
-	}
-
-	return true;
-}
-
-bool
-str_is_octal(const char *str, bool check_prefix)
-{
-	if (*str == '-' || *str == '+')
-		++str;
-
-	/* If checking the prefix, we need to look for '0o' or '0O' */
-	if (check_prefix) {
-		if (str[0] != '0')
-			return false;
-
-		if (str[1] != 'o' && str[1] != 'O')
-			return false;
+	if (p != end)
+		return TT_RAW_IDENT;
 
-		str += 2;
-	}
-
-	for (; *str != '\0'; ++str) {
-		if (*str < '0' || *str > '7')
-			return false;
-	}
+	if (!((whole && dot) || (dot && frac) || (whole && exp)))
+		return TT_RAW_IDENT;
 
-	return true;
+floating:
+	number->error = str_to_double(&(number->value.floating), str, len);
+	return TT_FLOAT;
 }
 
 // vim:ts=4:sw=4:autoindent
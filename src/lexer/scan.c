@@ -0,0 +1,381 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lexer/scan.h"
+
+/* Vector kernels look at 16 (SSE2, SSSE3) or 32 (AVX2) bytes at once, the
+ * scalar loops handle whatever is left and every other platform.
+ */
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__SSSE3__)
+#define SCAN_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#define SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(SCAN_SSE2) || defined(SCAN_SSSE3) || defined(SCAN_AVX2)
+/**
+ * Index of the first byte flagged in a movemask result.
+ */
+static size_t
+first_set(uint32_t mask)
+{
+	return (size_t)__builtin_ctz(mask);
+}
+#endif
+
+/**
+ * Byte classes for raw identifiers: [a-zA-Z0-9_:.+-]
+ */
+static const unsigned char raw_ident_class[256] = {
+	/* 0x00 - 0x1f: control characters */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 0x20 - 0x2f: '+', '-', '.' */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 0,
+	/* 0x30 - 0x3f: '0' - '9', ':' */
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+	/* 0x40 - 0x5f: 'A' - 'Z', '_' */
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+	/* 0x60 - 0x7f: 'a' - 'z' */
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+	/* 0x80 - 0xff: not ASCII */
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#if defined(SCAN_SSSE3) || defined(SCAN_AVX2)
+/* The same classes split up by nibble for pshufb: a byte is a raw
+ * identifier character if the entries for its high and low nibble share a
+ * bit.  The bits are:
+ *   0x01: 0x2_ for '+', '-', '.'
+ *   0x02: 0x3_ for '0' - '9', ':'
+ *   0x04: 0x4_ and 0x6_ for 'A' - 'O', 'a' - 'o'
+ *   0x08: 0x5_ for 'P' - 'Z', '_'
+ *   0x10: 0x7_ for 'p' - 'z'
+ */
+#define RAW_IDENT_HI_NIBBLES \
+	0, 0, 0x01, 0x02, 0x04, 0x08, 0x04, 0x10, 0, 0, 0, 0, 0, 0, 0, 0
+#define RAW_IDENT_LO_NIBBLES \
+	0x1a, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, \
+	0x1e, 0x1e, 0x1e, 0x05, 0x04, 0x05, 0x05, 0x0c
+#endif
+
+/**
+ * Length of the run of raw identifier characters at @p p.
+ */
+size_t
+scan_raw_ident(const char *p, const char *end)
+{
+	const char *start = p;
+
+#if defined(SCAN_AVX2)
+	{
+		const __m256i hi_table = _mm256_setr_epi8(RAW_IDENT_HI_NIBBLES,
+			RAW_IDENT_HI_NIBBLES);
+		const __m256i lo_table = _mm256_setr_epi8(RAW_IDENT_LO_NIBBLES,
+			RAW_IDENT_LO_NIBBLES);
+		const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+		for (; end - p >= 32; p += 32) {
+			__m256i v = _mm256_loadu_si256((const __m256i *)p);
+			__m256i hi = _mm256_shuffle_epi8(hi_table,
+				_mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+			__m256i lo = _mm256_shuffle_epi8(lo_table,
+				_mm256_and_si256(v, nibble));
+			__m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(hi, lo),
+				_mm256_setzero_si256());
+			uint32_t stop = (uint32_t)_mm256_movemask_epi8(none);
+
+			if (stop != 0)
+				return (size_t)(p - start) + first_set(stop);
+		}
+	}
+#endif
+
+#if defined(SCAN_SSSE3)
+	{
+		const __m128i hi_table = _mm_setr_epi8(RAW_IDENT_HI_NIBBLES);
+		const __m128i lo_table = _mm_setr_epi8(RAW_IDENT_LO_NIBBLES);
+		const __m128i nibble = _mm_set1_epi8(0x0f);
+
+		for (; end - p >= 16; p += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *)p);
+			__m128i hi = _mm_shuffle_epi8(hi_table,
+				_mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+			__m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, nibble));
+			__m128i none = _mm_cmpeq_epi8(_mm_and_si128(hi, lo),
+				_mm_setzero_si128());
+			uint32_t stop = (uint32_t)_mm_movemask_epi8(none);
+
+			if (stop != 0)
+				return (size_t)(p - start) + first_set(stop);
+		}
+	}
+#elif defined(SCAN_SSE2)
+	/* Without pshufb the classes are checked as ranges.  Bytes are signed
+	 * here, which conveniently puts everything non-ASCII out of range.
+	 */
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		/* Setting 0x20 folds 'A' - 'Z' onto 'a' - 'z'. */
+		__m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+		__m128i letter = _mm_and_si128(
+			_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+			_mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+		/* '0' - '9' and ':' */
+		__m128i digit = _mm_and_si128(
+			_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+			_mm_cmplt_epi8(v, _mm_set1_epi8(':' + 1)));
+		/* '-' and '.' */
+		__m128i punct = _mm_or_si128(
+			_mm_and_si128(
+				_mm_cmpgt_epi8(v, _mm_set1_epi8('-' - 1)),
+				_mm_cmplt_epi8(v, _mm_set1_epi8('.' + 1))),
+			_mm_or_si128(
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('+')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('_'))));
+		__m128i ident = _mm_or_si128(_mm_or_si128(letter, digit), punct);
+		uint32_t stop = ~(uint32_t)_mm_movemask_epi8(ident) & 0xffff;
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+	while (p < end && raw_ident_class[(unsigned char)*p])
+		++p;
+
+	return (size_t)(p - start);
+}
+
+/**
+ * Length of the run of string content at @p p that needs no attention:
+ * stops at @p delim, escapes, newlines (CR LF needs canonicalizing and LF
+ * needs line tracking) and anything that isn't ASCII.
+ */
+size_t
+scan_string(const char *p, const char *end, char delim)
+{
+	const char *start = p;
+
+#if defined(SCAN_AVX2)
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		__m256i special = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8(delim)),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+			_mm256_or_si256(
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+		uint32_t stop = (uint32_t)_mm256_movemask_epi8(
+			_mm256_or_si256(special, v));
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+#if defined(SCAN_SSE2)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i special = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(v, _mm_set1_epi8(delim)),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+			_mm_or_si128(
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+		uint32_t stop = (uint32_t)_mm_movemask_epi8(_mm_or_si128(special, v));
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+	for (; p < end; ++p) {
+		unsigned char c = (unsigned char)*p;
+
+		if (c >= 0x80 || c == (unsigned char)delim || c == '\\'
+				|| c == '\r' || c == '\n')
+			break;
+	}
+
+	return (size_t)(p - start);
+}
+
+/**
+ * Length of the run of spaces and tabs at @p p.
+ */
+size_t
+scan_whitespace(const char *p, const char *end)
+{
+	const char *start = p;
+
+#if defined(SCAN_AVX2)
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		__m256i ws = _mm256_or_si256(
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+		uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(ws);
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+#if defined(SCAN_SSE2)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i ws = _mm_or_si128(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+		uint32_t stop = ~(uint32_t)_mm_movemask_epi8(ws) & 0xffff;
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+	while (p < end && (*p == ' ' || *p == '\t'))
+		++p;
+
+	return (size_t)(p - start);
+}
+
+/**
+ * Length of the run of comment text at @p p: stops at CR, LF and anything
+ * that isn't ASCII (which still has to be validated).
+ */
+size_t
+scan_comment(const char *p, const char *end)
+{
+	const char *start = p;
+
+#if defined(SCAN_AVX2)
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		__m256i nl = _mm256_or_si256(
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+		/* The sign bit doubles as the non-ASCII test. */
+		uint32_t stop = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(nl, v));
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+#if defined(SCAN_SSE2)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i nl = _mm_or_si128(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+		uint32_t stop = (uint32_t)_mm_movemask_epi8(_mm_or_si128(nl, v));
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+	for (; p < end; ++p) {
+		unsigned char c = (unsigned char)*p;
+
+		if (c >= 0x80 || c == '\r' || c == '\n')
+			break;
+	}
+
+	return (size_t)(p - start);
+}
+
+/**
+ * Length of the run of ASCII bytes at @p p.
+ */
+size_t
+scan_ascii(const char *p, const char *end)
+{
+	const char *start = p;
+
+#if defined(SCAN_AVX2)
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		uint32_t stop = (uint32_t)_mm256_movemask_epi8(v);
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+#if defined(SCAN_SSE2)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		uint32_t stop = (uint32_t)_mm_movemask_epi8(v);
+
+		if (stop != 0)
+			return (size_t)(p - start) + first_set(stop);
+	}
+#endif
+
+	while (p < end && (unsigned char)*p < 0x80)
+		++p;
+
+	return (size_t)(p - start);
+}
+
+/**
+ * Number of codepoints in [p, end), which must hold complete UTF-8
+ * sequences: every byte but the continuation bytes (10xxxxxx) starts one.
+ */
+size_t
+scan_codepoints(const char *p, const char *end)
+{
+	size_t n = 0;
+
+#if defined(SCAN_AVX2)
+	for (; end - p >= 32; p += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)p);
+		/* As signed bytes continuation bytes are -128 to -65. */
+		__m256i lead = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(-65));
+
+		n += (size_t)__builtin_popcount(
+				(uint32_t)_mm256_movemask_epi8(lead));
+	}
+#endif
+
+#if defined(SCAN_SSE2)
+	for (; end - p >= 16; p += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i lead = _mm_cmpgt_epi8(v, _mm_set1_epi8(-65));
+
+		n += (size_t)__builtin_popcount(
+				(uint32_t)_mm_movemask_epi8(lead));
+	}
+#endif
+
+	for (; p < end; ++p)
+		n += (((unsigned char)*p & 0xc0) != 0x80);
+
+	return n;
+}
+
+// vim:ts=4:sw=4:autoindent
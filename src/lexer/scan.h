@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef H_PANCL_LEXER_SCAN
+#define H_PANCL_LEXER_SCAN
+
+#include <stddef.h>
+
+/* Each of these returns the length of the run of plain ASCII bytes starting
+ * at @p p (and ending before @p end) that the lexer can consume in bulk: no
+ * decoding, no line tracking and one codepoint per byte.
+ */
+size_t scan_whitespace(const char *p, const char *end);
+size_t scan_comment(const char *p, const char *end);
+size_t scan_raw_ident(const char *p, const char *end);
+size_t scan_string(const char *p, const char *end, char delim);
+
+/* Length of the run of ASCII bytes, of any kind, at @p p. */
+size_t scan_ascii(const char *p, const char *end);
+
+/* Number of codepoints in the (valid) UTF-8 text [p, end). */
+size_t scan_codepoints(const char *p, const char *end);
+
+#endif /* H_PANCL_LEXER_SCAN */
+// vim:ts=4:sw=4:autoindent
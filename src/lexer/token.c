@@ -15,17 +15,24 @@ token_init(struct token *t)
 	t->type = TT_UNSET;
 	t->subtype = TST_NONE;
 	t->string = NULL;
+	t->view = NULL;
+	t->view_bytes = 0;
+	t->view_codepoints = 0;
+	t->number.error = PANCL_SUCCESS;
 	t->loc.line = 0;
 	t->loc.column = 0;
+	t->loc.offset = 0;
+	t->loc.length = 0;
 }
 
 void
-token_fini(struct token *t)
+token_fini(struct pancl_context *ctx, struct token *t)
 {
 	if (t == NULL)
 		return;
 
-	pancl_utf8_string_destroy(&(t->string));
+	/* Token strings come from the context's pool (if any). */
+	pancl_utf8_string_release(ctx->pool, &(t->string));
 	token_init(t);
 }
 
@@ -41,38 +48,125 @@ token_set_string(struct token *t, int type, int subtype,
 	return PANCL_SUCCESS;
 }
 
+/**
+ * Allocation size of a string being built in a token buffer.
+ */
+#define TOKEN_STRING_SIZE(capacity) \
+	(offsetof(struct pancl_utf8_string, data) + (capacity))
+
 static int
-token_buffer_to_utf8_string(struct token_buffer *tb,
+token_buffer_to_utf8_string(struct pancl_pool *pool, struct token_buffer *tb,
 	struct pancl_utf8_string **string)
 {
-	/* tb->pos is the byte count. */
-	int err = pancl_utf8_string_new(string, tb->pos);
+	int err;
+
+	/* Short tokens get copied out of the scratch buffer. */
+	if (tb->string == NULL) {
+		/* tb->pos is the byte count. */
+		err = pancl_utf8_string_new(pool, string, tb->pos);
+
+		if (err != 0)
+			return err;
+
+		/* Copy in the string data. */
+		memcpy((*string)->data, tb->buffer, tb->pos + 1);
+		/* Set the code point count (bytes was already set). */
+		(*string)->codepoints = tb->codepoints;
+
+		return PANCL_SUCCESS;
+	}
 
-	if (err != 0)
+	/* Long ones already are the string, it only needs trimming to the size
+	 * pancl_utf8_string_release() expects.
+	 */
+	err = pancl_pool_resize(pool, (void **)&(tb->string), 1,
+			TOKEN_STRING_SIZE(tb->size),
+			sizeof(*(tb->string)) + tb->pos);
+
+	if (err != PANCL_SUCCESS)
 		return err;
 
-	/* Copy in the string data. */
-	memcpy((*string)->data, tb->buffer, tb->pos + 1);
-	/* Set the code point count (bytes was already set). */
+	*string = tb->string;
+	(*string)->bytes = tb->pos;
 	(*string)->codepoints = tb->codepoints;
 
+	tb->string = NULL;
+	tb->buffer = tb->scratch;
+	tb->size = sizeof(tb->scratch);
+
 	return PANCL_SUCCESS;
 }
 
 
 int
-token_set(struct token *t, int type, int subtype, struct token_buffer *tb)
+token_set(struct pancl_context *ctx, struct token *t, int type, int subtype,
+	struct token_buffer *tb)
 {
 	int err;
 	struct pancl_utf8_string *string = NULL;
 
-	err = token_buffer_to_utf8_string(tb, &string);
+	/* Borrowed content stays where it is. */
+	if (tb->view != NULL) {
+		err = token_set_empty(t, type, subtype);
+		t->view = tb->view;
+		t->view_bytes = tb->pos;
+		t->view_codepoints = tb->codepoints;
+		return err;
+	}
+
+	err = token_buffer_to_utf8_string(ctx->pool, tb, &string);
 
 	if (err == PANCL_SUCCESS)
 		err = token_set_string(t, type, subtype, string);
 
 	if (err != PANCL_SUCCESS)
-		pancl_utf8_string_destroy(&string);
+		pancl_utf8_string_release(ctx->pool, &string);
+
+	return err;
+}
+
+/**
+ * Sets a numeric token, whose value was already stored in @p t.
+ *
+ * The text of a number is only needed when it's used as a name or in an
+ * error, both of which are taken from the token right away, so a short one
+ * is left in the token buffer instead of being copied into a string.
+ */
+int
+token_set_number(struct pancl_context *ctx, struct token *t, int type,
+	struct token_buffer *tb)
+{
+	int err;
+
+	if (tb->view != NULL || tb->string != NULL)
+		return token_set(ctx, t, type, TST_IDENT, tb);
+
+	err = token_set_empty(t, type, TST_IDENT);
+	t->view = tb->buffer;
+	t->view_bytes = tb->pos;
+	t->view_codepoints = tb->codepoints;
+
+	return err;
+}
+
+/**
+ * Moves the text of a token into a pancl_string, copying it if it was
+ * borrowed from the input.
+ */
+int
+token_take_string(struct pancl_context *ctx, struct token *t,
+	unsigned int kind, pancl_string *dest)
+{
+	int err;
+
+	if (t->view == NULL)
+		return pancl_string_take(ctx->pool, kind, dest, &(t->string));
+
+	err = pancl_string_copy(ctx->pool, kind, dest, t->view, t->view_bytes,
+			t->view_codepoints);
+
+	if (err == PANCL_SUCCESS)
+		t->view = NULL;
 
 	return err;
 }
@@ -84,41 +178,174 @@ token_move(struct token *dest, struct token *src)
 	token_init(src);
 }
 
-int
-token_buffer_append_c(struct token_buffer *tb, char c)
+/**
+ * Makes sure the token buffer can hold at least @p size bytes.
+ */
+static int
+token_buffer_reserve(struct token_buffer *tb, size_t size)
 {
 	int err;
-	void *d;
 	size_t new_size;
 
-	if (tb->pos < tb->size)
-		goto append;
+	if (size <= tb->size)
+		return PANCL_SUCCESS;
 
-	err = safe_add(tb->size, TOKEN_BUFFER_STEP, &new_size);
+	/* Grow geometrically so long tokens are appended in amortized O(1). */
+	new_size = (tb->size > SIZE_MAX / 2) ? SIZE_MAX : tb->size * 2;
 
-	if (err != PANCL_SUCCESS)
-		return err;
+	if (new_size < size)
+		new_size = size;
+
+	if (safe_add(TOKEN_STRING_SIZE(0), new_size, &size) != PANCL_SUCCESS)
+		return PANCL_ERROR_OVERFLOW;
+
+	if (tb->string == NULL) {
+		/* Outgrew the scratch buffer: move over to the string that the
+		 * token will own.
+		 */
+		tb->string = pancl_pool_alloc(tb->pool, size);
 
-	d = pancl_realloc(tb->buffer, new_size);
+		if (tb->string == NULL)
+			return PANCL_ERROR_ALLOC;
 
-	if (d == NULL)
-		return PANCL_ERROR_ALLOC;
+		memcpy(tb->string->data, tb->buffer, tb->pos);
+	}
+	else {
+		err = pancl_pool_resize(tb->pool, (void **)&(tb->string), 1,
+				TOKEN_STRING_SIZE(tb->size), size);
 
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
+
+	tb->buffer = tb->string->data;
 	tb->size = new_size;
-	tb->buffer = d;
 
-append:
+	return PANCL_SUCCESS;
+}
+
+void
+token_buffer_init(struct token_buffer *tb)
+{
+	tb->pool = NULL;
+	tb->buffer = tb->scratch;
+	tb->size = sizeof(tb->scratch);
+	tb->pos = 0;
+	tb->codepoints = 0;
+	tb->view = NULL;
+	tb->string = NULL;
+}
+
+/**
+ * Releases a long token's string that didn't end up in a token.
+ */
+void
+token_buffer_discard(struct token_buffer *tb)
+{
+	if (tb->string == NULL)
+		return;
+
+	pancl_pool_free(tb->pool, tb->string, TOKEN_STRING_SIZE(tb->size));
+	tb->string = NULL;
+	tb->buffer = tb->scratch;
+	tb->size = sizeof(tb->scratch);
+}
+
+/**
+ * Copies borrowed content into the token buffer itself and NUL-terminates
+ * it.
+ */
+int
+token_buffer_own(struct token_buffer *tb)
+{
+	int err;
+	const char *view = tb->view;
+	size_t bytes = tb->pos;
+
+	if (view == NULL)
+		return PANCL_SUCCESS;
+
+	/* Nothing in the buffer itself is worth keeping. */
+	tb->view = NULL;
+	tb->pos = 0;
+
+	err = token_buffer_reserve(tb, bytes + 1);
+
+	if (err != PANCL_SUCCESS) {
+		tb->view = view;
+		tb->pos = bytes;
+		return err;
+	}
+
+	memcpy(tb->buffer, view, bytes);
+	tb->buffer[bytes] = '\0';
+	tb->pos = bytes;
+
+	return PANCL_SUCCESS;
+}
+
+int
+token_buffer_append_c(struct token_buffer *tb, char c)
+{
+	int err;
+
+	/* Borrowed content is no longer what we want once we modify it. */
+	err = token_buffer_own(tb);
+
+	if (err != PANCL_SUCCESS)
+		return err;
+
+	if (tb->pos >= tb->size) {
+		err = token_buffer_reserve(tb, tb->pos + 1);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
+
 	tb->buffer[tb->pos++] = c;
 	return PANCL_SUCCESS;
 }
 
+/**
+ * Appends @p n bytes of ASCII text in one go.
+ */
+int
+token_buffer_append_ascii(struct token_buffer *tb, const char *s, size_t n)
+{
+	int err;
+	size_t size;
+
+	err = token_buffer_own(tb);
+
+	if (err == PANCL_SUCCESS)
+		err = safe_add(tb->pos, n, &size);
+
+	if (err == PANCL_SUCCESS)
+		err = token_buffer_reserve(tb, size);
+
+	if (err != PANCL_SUCCESS)
+		return err;
+
+	memcpy(tb->buffer + tb->pos, s, n);
+	tb->pos += n;
+	tb->codepoints += n;
+
+	return PANCL_SUCCESS;
+}
+
 int
 token_buffer_end(struct token_buffer *tb)
 {
+	int err;
+
+	/* Borrowed content is used as-is. */
+	if (tb->view != NULL)
+		return PANCL_SUCCESS;
+
 	/* Using append_c since we know this is a single-byte and we don't want the
 	 * codepoint count to increase.
 	 */
-	int err = token_buffer_append_c(tb, '\0');
+	err = token_buffer_append_c(tb, '\0');
 
 	/* Decrement the position when we add the '\0' in case someone attempts to
 	 * append later (legal).
@@ -135,8 +362,7 @@ token_buffer_fini(struct token_buffer *tb)
 	if (tb == NULL)
 		return;
 
-	pancl_free(tb->buffer);
-	tb->buffer = NULL;
+	token_buffer_discard(tb);
 }
 
 // vim:ts=4:sw=4:autoindent
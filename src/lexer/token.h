@@ -90,11 +90,37 @@
  */
 #define TT_FALSE  311
 
+/**
+ * Value of a numeric token, decoded while lexing it.
+ */
+struct token_number {
+	/**
+	 * PANCL_ERROR_* if the literal is a number but not a valid value (too
+	 * large, leading zeros), reported if it's used as one.
+	 */
+	int error;
+	union {
+		int_least32_t integer; /**< TT_INT_* */
+		double floating; /**< TT_FLOAT */
+	} value;
+};
+
 struct token {
 	int type : 10; /**< What it be */
 	int subtype : 4; /**< What it also be */
 	struct pancl_utf8_string *string; /**< String value */
-	struct pancl_location loc; /**< Line / Column for token start */
+	/**
+	 * When @p string is NULL the text may instead be borrowed from a buffer
+	 * being parsed.  It is not NUL-terminated.
+	 *
+	 * Numeric tokens may also borrow it from the token buffer, in which case
+	 * it's only valid until the next token is lexed.
+	 */
+	const char *view;
+	size_t view_bytes; /**< Size of @p view in bytes */
+	size_t view_codepoints; /**< Number of codepoints in @p view */
+	struct token_number number; /**< TT_INT_* and TT_FLOAT value */
+	struct pancl_location loc; /**< Token start and the bytes it spans */
 };
 
 #define TOKEN_INIT \
@@ -102,19 +128,29 @@ struct token {
 		.type = TT_UNSET, \
 		.subtype = TST_NONE, \
 		.string = NULL, \
+		.view = NULL, \
+		.view_bytes = 0, \
+		.view_codepoints = 0, \
+		.number.error = PANCL_SUCCESS, \
 		.loc.line = 0, \
-		.loc.column = 0 \
+		.loc.column = 0, \
+		.loc.offset = 0, \
+		.loc.length = 0 \
 	}
 
 struct token_buffer;
 
 void token_init(struct token *t);
-void token_fini(struct token *t);
+void token_fini(struct pancl_context *ctx, struct token *t);
 void token_move(struct token *dest, struct token *src);
-int token_set(struct token *t, int type, int subtype,
-		struct token_buffer *tb);
+int token_set(struct pancl_context *ctx, struct token *t, int type,
+		int subtype, struct token_buffer *tb);
 int token_set_string(struct token *t, int type, int subtype,
 		struct pancl_utf8_string *string);
+int token_set_number(struct pancl_context *ctx, struct token *t, int type,
+		struct token_buffer *tb);
+int token_take_string(struct pancl_context *ctx, struct token *t,
+		unsigned int kind, pancl_string *dest);
 
 static inline int
 token_set_empty(struct token *t, int type, int subtype)
@@ -122,30 +158,95 @@ token_set_empty(struct token *t, int type, int subtype)
 	return token_set_string(t, type, subtype, NULL);
 }
 
+/**
+ * Text of a token, whether it owns it or borrows it.  Not necessarily
+ * NUL-terminated.
+ */
+static inline const char *
+token_text(const struct token *t, size_t *bytes)
+{
+	if (t->string != NULL) {
+		*bytes = t->string->bytes;
+		return t->string->data;
+	}
+
+	*bytes = (t->view != NULL) ? t->view_bytes : 0;
+	return t->view;
+}
+
+
+#define TOKEN_BUFFER_INLINE  256
 
 struct token_buffer {
-	char *buffer;
+	struct pancl_pool *pool; /**< Where token strings are allocated from */
+	char *buffer; /**< Either @p scratch or the data of @p string */
 	size_t size; /**< In bytes */
 	size_t pos; /**< Byte position */
 	size_t codepoints; /**< Number of stored codepoints. */
+	/**
+	 * Input the content is borrowed from instead of @p buffer (the first
+	 * @p pos bytes).  Appending makes a copy first.
+	 */
+	const char *view;
+	/**
+	 * Tokens that outgrow @p scratch are built in place in the string that
+	 * the token ends up owning.
+	 */
+	struct pancl_utf8_string *string;
+	/**
+	 * Reused storage for short tokens, they are copied into a string of the
+	 * right size once complete.
+	 */
+	char scratch[TOKEN_BUFFER_INLINE];
 };
 
-#define TOKEN_BUFFER_STEP  512
-#define TOKEN_BUFFER_INIT \
-	{ \
-		.buffer = NULL, \
-		.size = 0, \
-		.pos = 0, \
-		.codepoints = 0 \
-	}
+void token_buffer_init(struct token_buffer *tb);
+void token_buffer_discard(struct token_buffer *tb);
 
 static inline void
 token_buffer_reset(struct token_buffer *tb)
 {
+	/* A long token that never made it into a token. */
+	if (tb->string != NULL)
+		token_buffer_discard(tb);
+
 	tb->pos = 0;
 	tb->codepoints = 0;
+	tb->view = NULL;
+}
+
+/**
+ * Starts borrowing the content of an empty token buffer from @p start, which
+ * must stay valid for as long as the token does.
+ */
+static inline void
+token_buffer_borrow(struct token_buffer *tb, const char *start)
+{
+	tb->view = start;
+}
+
+/**
+ * Adds the next @p codepoints codepoints (@p bytes long) of the input to a
+ * borrowed token buffer.
+ */
+static inline void
+token_buffer_extend(struct token_buffer *tb, size_t bytes, size_t codepoints)
+{
+	tb->pos += bytes;
+	tb->codepoints += codepoints;
 }
 
+/**
+ * Current content of the token buffer, not necessarily NUL-terminated.
+ */
+static inline const char *
+token_buffer_data(const struct token_buffer *tb)
+{
+	return (tb->view != NULL) ? tb->view : tb->buffer;
+}
+
+int token_buffer_own(struct token_buffer *tb);
+
 /* Internal shouldn't be used directly except by the utf-8 code. */
 int token_buffer_append_c(struct token_buffer *tb, char c);
 
@@ -153,13 +254,24 @@ int token_buffer_append_c(struct token_buffer *tb, char c);
 static inline int
 token_buffer_append(struct token_buffer *tb, uint_fast32_t val)
 {
+	/* ASCII needs no encoding. */
+	if (val < 0x80 && tb->view == NULL && tb->pos < tb->size) {
+		tb->buffer[tb->pos++] = (char)val;
+		tb->codepoints += 1;
+		return PANCL_SUCCESS;
+	}
+
 	return encode_utf8(tb, val);
 }
 
+int token_buffer_append_ascii(struct token_buffer *tb, const char *s,
+		size_t n);
+
 int token_buffer_end(struct token_buffer *tb);
 void token_buffer_fini(struct token_buffer *tb);
 
 
+struct pancl_location lexer_location(struct pancl_context *ctx);
 int lexer_rewind_token(struct pancl_context *ctx, struct token *t);
 int next_token(struct pancl_context *ctx, struct token_buffer *tb,
 		struct token *t);
@@ -1,9 +1,11 @@
 /* SPDX-License-Identifier: MIT */
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "pancl/pancl.h"
+#include "lexer/scan.h"
 #include "lexer/token.h"
 #include "lexer/utf8.h"
 
@@ -336,4 +338,85 @@ decode_utf8(unsigned char *bytes, uint_fast32_t *storage)
 	return PANCL_SUCCESS;
 }
 
+/**
+ * Checks an entire input for well-formed UTF-8 (RFC 3629) without
+ * noncharacters U+FFFE and U+FFFF: every sequence complete, no overlong
+ * forms, no surrogates and nothing above U+10FFFF.  ASCII runs are skipped
+ * with scan_ascii(), so mostly-ASCII input costs little more than a memchr.
+ *
+ * Everything accepted here is accepted by decode_utf8() with the same value,
+ * so the lexer can use decode_utf8_valid() on such input.  Input that is
+ * rejected (which includes some that decode_utf8() lets through, like
+ * overlong forms) is simply lexed with the checks, which then report any
+ * errors at their exact location.
+ *
+ * @param[in] data   Input to check
+ * @param[in] size   Length of @p data in bytes
+ *
+ * @return Returns true if the input is valid.
+ */
+bool
+utf8_validate(const char *data, size_t size)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	const unsigned char *end = p + size;
+
+	for (;;) {
+		size_t i;
+		size_t length;
+		unsigned char low = 0x80;
+		unsigned char high = 0xbf;
+
+		p += scan_ascii((const char *)p, (const char *)end);
+
+		if (p == end)
+			return true;
+
+		/* 0xc0 and 0xc1 only start overlong forms, 0xf5 and up only
+		 * values above U+10FFFF.
+		 */
+		if (*p < 0xc2 || *p > 0xf4)
+			return false;
+
+		length = utf8_length_lookup[*p];
+
+		if ((size_t)(end - p) < length)
+			return false;
+
+		/* The second byte's range also rules out overlong 3 and 4 byte
+		 * forms, surrogates (0xed 0xa0 - 0xbf) and values above U+10FFFF.
+		 */
+		switch (*p) {
+		case 0xe0:
+			low = 0xa0;
+			break;
+		case 0xed:
+			high = 0x9f;
+			break;
+		case 0xf0:
+			low = 0x90;
+			break;
+		case 0xf4:
+			high = 0x8f;
+			break;
+		default:
+			break;
+		}
+
+		if (p[1] < low || p[1] > high)
+			return false;
+
+		for (i = 2; i < length; ++i) {
+			if ((p[i] & 0xc0) != 0x80)
+				return false;
+		}
+
+		/* U+FFFE and U+FFFF (0xef 0xbf 0xbe and 0xef 0xbf 0xbf). */
+		if (p[0] == 0xef && p[1] == 0xbf && p[2] >= 0xbe)
+			return false;
+
+		p += length;
+	}
+}
+
 // vim:ts=4:sw=4:autoindent
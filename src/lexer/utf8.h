@@ -2,6 +2,7 @@
 #ifndef H_PANCL_LEXER_UTF8
 #define H_PANCL_LEXER_UTF8
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -14,5 +15,37 @@ size_t utf8_length_c_slow(unsigned char first_byte);
 int encode_utf8(struct token_buffer *tb, uint_fast32_t val);
 int decode_utf8(unsigned char *bytes, uint_fast32_t *storage);
 
+bool utf8_validate(const char *data, size_t size);
+
+/**
+ * Decodes the (non-ASCII) codepoint at @p bytes, which has to be part of an
+ * input that passed utf8_validate().  None of the checks decode_utf8()
+ * does are needed then.
+ *
+ * @return Returns the length of the sequence in bytes.
+ */
+static inline size_t
+decode_utf8_valid(const unsigned char *bytes, uint_fast32_t *storage)
+{
+	if (bytes[0] < 0xe0) {
+		*storage = ((uint_fast32_t)(bytes[0] & 0x1f) << 6)
+			| (bytes[1] & 0x3f);
+		return 2;
+	}
+
+	if (bytes[0] < 0xf0) {
+		*storage = ((uint_fast32_t)(bytes[0] & 0x0f) << 12)
+			| ((uint_fast32_t)(bytes[1] & 0x3f) << 6)
+			| (bytes[2] & 0x3f);
+		return 3;
+	}
+
+	*storage = ((uint_fast32_t)(bytes[0] & 0x07) << 18)
+		| ((uint_fast32_t)(bytes[1] & 0x3f) << 12)
+		| ((uint_fast32_t)(bytes[2] & 0x3f) << 6)
+		| (bytes[3] & 0x3f);
+	return 4;
+}
+
 #endif /* H_PANCL_LEXER_UTF8 */
 // vim:ts=4:sw=4:autoindent
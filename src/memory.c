@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: MIT */
 #include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,8 +56,50 @@ pancl_realloc(void *p, size_t n)
 	return pancl_realloc_fn(p, n);
 }
 
+bool
+pancl_allocator_is_default(const struct pancl_allocator *allocator)
+{
+	return (allocator == NULL || allocator->alloc == NULL);
+}
+
+void *
+pancl_allocator_alloc(const struct pancl_allocator *allocator, size_t n)
+{
+	if (pancl_allocator_is_default(allocator))
+		return pancl_alloc(n);
+
+	return allocator->alloc(allocator->state, n);
+}
+
+void *
+pancl_allocator_realloc(const struct pancl_allocator *allocator, void *p,
+	size_t old_size, size_t n)
+{
+	if (pancl_allocator_is_default(allocator))
+		return pancl_realloc(p, n);
+
+	if (p == NULL)
+		return allocator->alloc(allocator->state, n);
+
+	return allocator->realloc(allocator->state, p, old_size, n);
+}
+
+void
+pancl_allocator_free(const struct pancl_allocator *allocator, void *p,
+	size_t size)
+{
+	if (pancl_allocator_is_default(allocator)) {
+		pancl_free(p);
+		return;
+	}
+
+	if (p != NULL)
+		allocator->free(allocator->state, p, size);
+}
+
 int
-pancl_resize(void **p, size_t n, size_t count)
+pancl_resize(const struct pancl_allocator *allocator, void **p, size_t n,
+	size_t old_count, size_t count)
 {
 	int err;
 	size_t size;
@@ -70,7 +113,8 @@ pancl_resize(void **p, size_t n, size_t count)
 	if (err != 0)
 		return err;
 
-	d = pancl_realloc(*p, size);
+	/* The old size can't overflow, it was allocated with it. */
+	d = pancl_allocator_realloc(allocator, *p, n * old_count, size);
 
 	if (d == NULL)
 		return PANCL_ERROR_ALLOC;
@@ -1,15 +1,24 @@
 /* SPDX-License-Identifier: MIT */
+/* fileno(), read(2) and posix_fadvise() */
+#define _POSIX_C_SOURCE 200112L
+
 #include <errno.h>
 #include <ctype.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
 
 #include "internal.h"
 #include "pancl/pancl.h"
 #include "lexer/token.h"
+#include "lexer/utf8.h"
 
 /**
  * @file pancl.c
@@ -18,10 +27,16 @@
 
 
 /**
- * Size of buffer to allocate for reading.
+ * Smallest amount read at a time, unless pancl_context_set_buffer_size()
+ * asks for less.
  */
 #define DEFAULT_BUFFER_SIZE  (8192)
 
+/**
+ * Largest amount read at a time when sizing the buffer from a regular file.
+ */
+#define MAX_BUFFER_SIZE  ((size_t)1 << 20)
+
 
 /**
  * A do-nothing read operation for cases where the input is a single buffer
@@ -58,6 +73,62 @@ static const struct pancl_parse_operations buffer_parse_ops = {
 };
 
 
+/**
+ * Tells the kernel a file is about to be read from start to end, so it can
+ * read ahead more aggressively.  Only a hint; failures are ignored.
+ *
+ * @param[in] fd   Descriptor to advise on, may be -1
+ */
+static void
+advise_sequential(int fd)
+{
+#ifdef POSIX_FADV_SEQUENTIAL
+	if (fd >= 0)
+		(void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+	(void)fd;
+#endif
+}
+
+/**
+ * Picks how much to read at a time from @p fd.
+ *
+ * Regular files are read in one go, up to MAX_BUFFER_SIZE, which saves
+ * round trips on network filesystems.  Pipes, sockets and the like are read
+ * in blocks of DEFAULT_BUFFER_SIZE, or the preferred I/O size if larger.
+ *
+ * @param[in] ctx   Context, pancl_context_set_buffer_size() overrides this
+ * @param[in] fd    Descriptor to read from, -1 if unknown
+ *
+ * @return Returns the read size in bytes.
+ */
+static size_t
+read_size_for(const struct pancl_context *ctx, int fd)
+{
+	struct stat st;
+	size_t size = DEFAULT_BUFFER_SIZE;
+
+	if (ctx->read_size != 0)
+		return ctx->read_size;
+
+	if (fd < 0 || fstat(fd, &st) != 0)
+		return size;
+
+	if (st.st_blksize > 0 && (size_t)st.st_blksize > size)
+		size = (size_t)st.st_blksize;
+
+	if (S_ISREG(st.st_mode) && st.st_size > 0) {
+		if ((uintmax_t)st.st_size >= MAX_BUFFER_SIZE)
+			return MAX_BUFFER_SIZE;
+
+		if ((size_t)st.st_size > size)
+			size = (size_t)st.st_size;
+	}
+
+	return (size > MAX_BUFFER_SIZE) ? MAX_BUFFER_SIZE : size;
+}
+
+
 /**
  * Initialization operation for reading from a FILE pointer.
  *
@@ -73,6 +144,7 @@ file_init(void *ops_data)
 	FILE *f = ops_data;
 
 	rewind(f); /* Also clears the stream error indicator (clearerr()). */
+	advise_sequential(fileno(f));
 	return 0;
 }
 
@@ -120,13 +192,79 @@ static const struct pancl_parse_operations file_parse_ops = {
 };
 
 
+/**
+ * Initialization operation for reading from a file descriptor.
+ *
+ * @param[in] ops_data   Descriptor, stored as an intptr_t
+ *
+ * @return Returns 0 on success and non-zero on failure.
+ *
+ * @see fd_parse_ops
+ */
+static int
+fd_init(void *ops_data)
+{
+	int fd = (int)(intptr_t)ops_data;
+
+	/* Like rewind(), which can't do anything about pipes either. */
+	if (lseek(fd, 0, SEEK_SET) == (off_t)-1 && errno != ESPIPE)
+		return -errno;
+
+	advise_sequential(fd);
+	return 0;
+}
+
+
+/**
+ * File descriptor read operation.
+ *
+ * @param[in] ops_data   Descriptor to read from, stored as an intptr_t
+ * @param[out] store     Buffer to read into
+ * @param[in,out] size   Size of @p store and the returned read size
+ *
+ * @return
+ *   Returns 0 on success and non-zero on failure.  Upon successful return,
+ *   The value stored in @p size is updated to reflect the number of bytes
+ *   read into @p store.
+ *
+ * @see fd_parse_ops
+ */
+static int
+fd_next(void *ops_data, void *store, size_t *size)
+{
+	ssize_t ret;
+	int fd = (int)(intptr_t)ops_data;
+
+	do {
+		ret = read(fd, store, *size);
+	} while (ret == -1 && errno == EINTR);
+
+	if (ret < 0)
+		return -errno;
+
+	/* Short reads are fine, only 0 means the end of the file. */
+	*size = (size_t)ret;
+	return 0;
+}
+
+/**
+ * Parse operations for reading from a file descriptor.
+ */
+static const struct pancl_parse_operations fd_parse_ops = {
+	.init = fd_init,
+	.next = fd_next,
+	.fini = NULL
+};
+
+
 /**
  * Common backend setup function for a pancl_context.
  *
  * @param[out] ctx           The context to initialize
  * @param[in] ops            Parse operations to use
  * @param[in] ops_data       Operation-specific data
- * @param[in] alloc_buffer   If a read buffer needs to be allocated
+ * @param[in] read_size      Bytes to read at a time, 0 if there's nothing
+ *                           to read into a buffer
  *
  * @retval PANCL_SUCCESS             Success
  * @retval PANCL_ERROR_ARG_INVALID   Invalid parameter
@@ -136,25 +274,39 @@ static const struct pancl_parse_operations file_parse_ops = {
 static int
 pancl_context_setup(struct pancl_context *ctx,
 	const struct pancl_parse_operations *ops, void *ops_data,
-	bool alloc_buffer)
+	size_t read_size)
 {
 	int err;
+	unsigned int flags;
+	size_t buffer_size;
+	struct pancl_allocator allocator;
 
 	if (ctx == NULL || ops == NULL || ops->next == NULL)
 		return PANCL_ERROR_ARG_INVALID;
 
+	/* Flags, the allocator and the buffer size are configuration, not parse
+	 * state, so they survive the reset.
+	 */
+	flags = ctx->flags;
+	allocator = ctx->allocator;
+	buffer_size = ctx->read_size;
 	pancl_context_init(ctx);
+	ctx->flags = flags;
+	ctx->allocator = allocator;
+	ctx->read_size = buffer_size;
 
 	ctx->ops = ops;
 	ctx->ops_data = ops_data;
 
-	if (alloc_buffer) {
-		ctx->allocated_buffer = pancl_alloc(DEFAULT_BUFFER_SIZE);
+	if (read_size != 0) {
+		buffer_size = REFILL_HEADROOM + read_size;
+		ctx->allocated_buffer = pancl_allocator_alloc(&(ctx->allocator),
+			buffer_size);
 
 		if (ctx->allocated_buffer == NULL)
 			return PANCL_ERROR_ALLOC;
 
-		ctx->buffer_size = DEFAULT_BUFFER_SIZE;
+		ctx->buffer_size = buffer_size;
 	}
 
 	if (ops->init != NULL)
@@ -163,7 +315,8 @@ pancl_context_setup(struct pancl_context *ctx,
 		err = 0;
 
 	if (err != 0) {
-		pancl_free(ctx->allocated_buffer);
+		pancl_allocator_free(&(ctx->allocator), ctx->allocated_buffer,
+			ctx->buffer_size);
 		ctx->allocated_buffer = NULL;
 		return PANCL_ERROR_CTX_INIT;
 	}
@@ -185,10 +338,32 @@ pancl_context_setup(struct pancl_context *ctx,
 int
 pancl_parse_file(struct pancl_context *ctx, FILE *file)
 {
-	if (file == NULL)
+	if (file == NULL || ctx == NULL)
 		return PANCL_ERROR_ARG_INVALID;
 
-	return pancl_context_setup(ctx, &file_parse_ops, file, true);
+	return pancl_context_setup(ctx, &file_parse_ops, file,
+		read_size_for(ctx, fileno(file)));
+}
+
+
+/**
+ * Sets up a pancl_context to parse from a file descriptor.
+ *
+ * @param[out] ctx   The context to initialize
+ * @param[in] fd     Descriptor open for reading
+ *
+ * @retval PANCL_SUCCESS             Success
+ * @retval PANCL_ERROR_ARG_INVALID   Invalid parameter
+ * @retval PANCL_ERROR_*             Other failures
+ */
+int
+pancl_parse_fd(struct pancl_context *ctx, int fd)
+{
+	if (fd < 0 || ctx == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	return pancl_context_setup(ctx, &fd_parse_ops, (void *)(intptr_t)fd,
+		read_size_for(ctx, fd));
 }
 
 
@@ -211,12 +386,18 @@ pancl_parse_buffer(struct pancl_context *ctx, const void *buffer, size_t size)
 	if (buffer == NULL)
 		return PANCL_ERROR_ARG_INVALID;
 
-	err = pancl_context_setup(ctx, &buffer_parse_ops, NULL, false);
+	err = pancl_context_setup(ctx, &buffer_parse_ops, NULL, 0);
 
 	if (err == PANCL_SUCCESS) {
 		/* Set these after setup since setup NULLs them. */
 		ctx->cursor = buffer;
 		ctx->end = ctx->cursor + size;
+		ctx->loc_cursor = ctx->cursor;
+
+		/* Checking the whole buffer up front lets the lexer skip all of
+		 * the per-codepoint checks.
+		 */
+		ctx->input_valid = utf8_validate(buffer, size);
 	}
 
 	return err;
@@ -242,6 +423,29 @@ pancl_parse_string(struct pancl_context *ctx, const char *string)
 }
 
 
+/**
+ * Retrieves the ABI version the library was built with.
+ *
+ * @return Returns PANCL_ABI_VERSION as seen when building the library.
+ */
+int
+pancl_lib_abi_version(void)
+{
+	return PANCL_ABI_VERSION;
+}
+
+/**
+ * Retrieves the layout-affecting build options the library was built with.
+ *
+ * @return Returns PANCL_BUILD_FLAGS as seen when building the library.
+ */
+unsigned int
+pancl_lib_build_flags(void)
+{
+	return PANCL_BUILD_FLAGS;
+}
+
+
 /**
  * Initialize a pancl_context so that it may be safely passed to
  * any function accepting a pancl_context.
@@ -255,6 +459,92 @@ pancl_context_init(struct pancl_context *ctx)
 		memset(ctx, 0, sizeof(*ctx));
 }
 
+/**
+ * Retrieves the current position of the parser in its input.
+ *
+ * @param[in] ctx   Context attached to some form of input
+ * @param[out] loc  Location to store the position in
+ */
+void
+pancl_context_location(struct pancl_context *ctx, struct pancl_location *loc)
+{
+	*loc = lexer_location(ctx);
+}
+
+/**
+ * Makes a pancl_context allocate through @p allocator.
+ *
+ * @param[out] ctx        The context to configure
+ * @param[in] allocator   Allocator to use, NULL for the library defaults
+ *
+ * @retval PANCL_SUCCESS             Success
+ * @retval PANCL_ERROR_ARG_INVALID   Invalid parameter or context in use
+ */
+int
+pancl_context_set_allocator(struct pancl_context *ctx,
+	const struct pancl_allocator *allocator)
+{
+	if (ctx == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	/* Memory already handed out must be freed by whoever allocated it. */
+	if (ctx->ops != NULL || ctx->pool != NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	if (allocator == NULL) {
+		memset(&(ctx->allocator), 0, sizeof(ctx->allocator));
+		return PANCL_SUCCESS;
+	}
+
+	if (allocator->alloc == NULL || allocator->realloc == NULL
+			|| allocator->free == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	ctx->allocator = *allocator;
+	return PANCL_SUCCESS;
+}
+
+/**
+ * Sets the read buffer size of a pancl_context.
+ *
+ * @param[out] ctx   The context to configure
+ * @param[in] size   Bytes to read at a time, 0 to size it from the input
+ *
+ * @retval PANCL_SUCCESS             Success
+ * @retval PANCL_ERROR_ARG_INVALID   Invalid parameter
+ */
+int
+pancl_context_set_buffer_size(struct pancl_context *ctx, size_t size)
+{
+	if (ctx == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	if (size != 0 && (size < PANCL_BUFFER_SIZE_MIN
+			|| size > SIZE_MAX - REFILL_HEADROOM))
+		return PANCL_ERROR_ARG_INVALID;
+
+	ctx->read_size = size;
+	return PANCL_SUCCESS;
+}
+
+/**
+ * Releases the error token of a pancl_context.
+ *
+ * @param[out] ctx   The context to clean up
+ */
+void
+pancl_context_clear_error(struct pancl_context *ctx)
+{
+	struct pancl_utf8_string *string = ctx->error_token;
+
+	if (string == NULL)
+		return;
+
+	pancl_allocator_free(&(ctx->allocator), string,
+		sizeof(*string) + string->bytes);
+	ctx->error_token = NULL;
+}
+
 /**
  * Cleans up a pancl_context.
  *
@@ -274,14 +564,25 @@ pancl_context_fini(struct pancl_context *ctx)
 	if (ctx->ops != NULL && ctx->ops->fini != NULL)
 		ctx->ops->fini(ctx->ops_data);
 
-	pancl_utf8_string_destroy(&(ctx->error_token));
-	pancl_free(ctx->allocated_buffer);
+	pancl_context_clear_error(ctx);
+	pancl_allocator_free(&(ctx->allocator), ctx->allocated_buffer,
+		ctx->buffer_size);
 
 	if (ctx->token1 != NULL) {
-		token_fini(ctx->token1);
-		pancl_free(ctx->token1);
+		token_fini(ctx, ctx->token1);
+		pancl_allocator_free(&(ctx->allocator), ctx->token1,
+			sizeof(struct token));
+	}
+
+	if (ctx->token_buffer != NULL) {
+		token_buffer_fini(ctx->token_buffer);
+		pancl_allocator_free(&(ctx->allocator), ctx->token_buffer,
+			sizeof(struct token_buffer));
 	}
 
+	/* Tables still holding on to the pool keep it alive. */
+	pancl_pool_unref(&(ctx->pool));
+
 	/* Reset all the fields. */
 	pancl_context_init(ctx);
 }
@@ -10,42 +10,43 @@
 #include "parser/str_to_int.h"
 
 static int
-handle_int(struct pancl_value *value, enum pancl_type type)
+handle_int(struct pancl_pool *pool, struct pancl_value *value,
+	enum pancl_type type)
 {
 	int err = PANCL_ERROR_ARG_INVALID;
 	union pancl_type_union new_data;
 	const char *str = NULL;
-	struct pancl_utf8_string *utf8_str = NULL;
+	const pancl_string *utf8_str = NULL;
 	int base = 0;
 
-	struct pancl_tuple *tuple = &(value->data.custom.tuple);
+	struct pancl_tuple *tuple = &(pancl_value_custom(value)->tuple);
 
 	/* Validate the tuple. */
 	if (tuple->count < 1 || tuple->count > 2)
 		return PANCL_ERROR_OPT_INT_ARG_COUNT;
 
 	/* [Arg 0] Validate and grab the string portion */
-	if (tuple->values[0]->type != PANCL_TYPE_STRING)
+	if (pancl_tuple_at(tuple, 0)->type != PANCL_TYPE_STRING)
 		return PANCL_ERROR_OPT_INT_ARG_0_NOT_STRING;
 
-	utf8_str = tuple->values[0]->data.string;
+	utf8_str = &(pancl_tuple_at(tuple, 0)->data.string);
 
 	/* [Arg 1] Validate and grab the optional base portion */
 	if (tuple->count == 2) {
-		if (tuple->values[1]->type != PANCL_TYPE_INTEGER)
+		if (pancl_tuple_at(tuple, 1)->type != PANCL_TYPE_INTEGER)
 			return PANCL_ERROR_OPT_INT_ARG_1_NOT_INT;
 
-		base = (int)tuple->values[1]->data.integer;
+		base = (int)pancl_tuple_at(tuple, 1)->data.integer;
 	}
 
 	/* Make sure the string is in a good format (ascii and no embedded NULs) */
-	if (!pancl_utf8_string_is_ascii(utf8_str))
+	if (!pancl_string_is_ascii(utf8_str))
 		return PANCL_ERROR_STR_TO_INT_CHAR;
 
-	if (pancl_utf8_string_contains_nul(utf8_str))
+	if (pancl_string_contains_nul(utf8_str))
 		return PANCL_ERROR_STR_TO_INT_CHAR;
 
-	str = utf8_str->data;
+	str = pancl_string_data(utf8_str);
 
 	switch (type) {
 	case PANCL_TYPE_INTEGER:
@@ -89,11 +90,13 @@ handle_int(struct pancl_value *value, enum pancl_type type)
 	}
 
 	if (err == PANCL_SUCCESS) {
-		/* Clean up the old value */
-		pancl_value_fini(value);
+		/* Clean up the custom type, but keep the rest of the value (its
+		 * location) as it is.
+		 */
+		pancl_value_fini_data(pool, value);
 
 		/* Set the new value. */
-		pancl_value_init(value, type);
+		value->type = type;
 		value->data = new_data;
 	}
 
@@ -102,50 +105,50 @@ handle_int(struct pancl_value *value, enum pancl_type type)
 
 
 int
-handle_known_custom_types(struct pancl_value *value)
+handle_known_custom_types(struct pancl_pool *pool, struct pancl_value *value)
 {
-	struct pancl_utf8_string *name = value->data.custom.name;
+	const pancl_string *type_name = &(pancl_value_custom(value)->name);
+	const char *name;
 
 	/* Custom type names come from Raw Identifiers so they can
 	 * only ever be ASCII but we validate the assumption regardless.
 	 */
-	if (!pancl_utf8_string_is_ascii(name))
+	if (!pancl_string_is_ascii(type_name))
 		return PANCL_SUCCESS;
 
-	if (pancl_utf8_string_contains_nul(name))
+	if (pancl_string_contains_nul(type_name))
 		return PANCL_SUCCESS;
 
-	if (strcmp(name->data, "::Integer") == 0)
-		return handle_int(value, PANCL_TYPE_INTEGER);
+	name = pancl_string_data(type_name);
 
-	if (strcmp(name->data, "::Int8") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_INT8);
+	if (strcmp(name, "::Integer") == 0)
+		return handle_int(pool, value, PANCL_TYPE_INTEGER);
 
-	if (strcmp(name->data, "::Uint8") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_UINT8);
+	if (strcmp(name, "::Int8") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_INT8);
 
-	if (strcmp(name->data, "::Int16") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_INT16);
+	if (strcmp(name, "::Uint8") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_UINT8);
 
-	if (strcmp(name->data, "::Uint16") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_UINT16);
+	if (strcmp(name, "::Int16") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_INT16);
 
-	if (strcmp(name->data, "::Int32") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_INT32);
+	if (strcmp(name, "::Uint16") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_UINT16);
 
-	if (strcmp(name->data, "::Uint32") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_UINT32);
+	if (strcmp(name, "::Int32") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_INT32);
 
-	if (strcmp(name->data, "::Int64") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_INT64);
+	if (strcmp(name, "::Uint32") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_UINT32);
 
-	if (strcmp(name->data, "::Uint64") == 0)
-		return handle_int(value, PANCL_TYPE_OPT_UINT64);
+	if (strcmp(name, "::Int64") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_INT64);
 
-#if 0 /* XXX: Implement at some point. */
-	if (strcmp(name->data, "::Float") == 0)
-		return handle_float(value);
-#endif
+	if (strcmp(name, "::Uint64") == 0)
+		return handle_int(pool, value, PANCL_TYPE_OPT_UINT64);
+
+	/* ::Float is converted by the parser, straight from its tokens. */
 
 	/* Unhandled, just let the end-user handle it. */
 	return PANCL_SUCCESS;
@@ -2,9 +2,11 @@
 #ifndef H_PANCL_PARSER_CUSTOM_TYPES
 #define H_PANCL_PARSER_CUSTOM_TYPES
 
+struct pancl_pool;
 struct pancl_value;
 
-int handle_known_custom_types(struct pancl_value *value);
+int handle_known_custom_types(struct pancl_pool *pool,
+		struct pancl_value *value);
 
 #endif /* H_PANCL_PARSER_CUSTOM_TYPES */
 // vim:ts=4:sw=4:autoindent
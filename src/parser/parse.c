@@ -12,7 +12,7 @@
 #include "internal.h"
 #include "lexer/token.h"
 #include "parser/custom_types.h"
-#include "parser/str_to_int.h"
+#include "parser/str_to_float.h"
 
 /**
  * Return value for a terminator function.
@@ -37,10 +37,72 @@ context_set_error(struct pancl_context *ctx, struct token *t)
 {
 	ctx->error_loc = t->loc;
 
-	pancl_utf8_string_destroy(&(ctx->error_token));
-	ctx->error_token = t->string;
+	pancl_context_clear_error(ctx);
 
-	t->string = NULL;
+	/* The error token can outlive the pool the token string came from (and
+	 * arena memory can't be freed individually), so it is copied out with
+	 * the context's allocator.  This is best-effort, the error token is
+	 * allowed to be NULL.
+	 */
+	if (t->string != NULL || t->view != NULL) {
+		const char *data = t->view;
+		size_t bytes = t->view_bytes;
+		size_t codepoints = t->view_codepoints;
+		struct pancl_utf8_string *error_token;
+
+		if (t->string != NULL) {
+			data = t->string->data;
+			bytes = t->string->bytes;
+			codepoints = t->string->codepoints;
+		}
+
+		error_token = pancl_allocator_alloc(&(ctx->allocator),
+			sizeof(*error_token) + bytes);
+
+		if (error_token != NULL) {
+			error_token->bytes = bytes;
+			error_token->codepoints = codepoints;
+			memcpy(error_token->data, data, bytes);
+			error_token->data[bytes] = '\0';
+		}
+
+		ctx->error_token = error_token;
+
+		/* Only the text goes, callers still look at the token type. */
+		pancl_utf8_string_release(ctx->pool, &(t->string));
+		t->view = NULL;
+	}
+}
+
+/**
+ * The location of a parsed node, NULL if nodes don't have one.
+ */
+#if defined(PANCL_NO_LOCATIONS)
+#  define NODE_LOCATION(node)  ((struct pancl_location *)NULL)
+#else
+#  define NODE_LOCATION(node)  (&((node)->loc))
+#endif
+
+/**
+ * Sets a node's location, unless locations aren't tracked.
+ */
+static void
+location_set(const struct pancl_context *ctx, struct pancl_location *loc,
+	const struct pancl_location *src)
+{
+	if (context_tracks_locations(ctx))
+		*loc = *src;
+}
+
+/**
+ * Stretches @p loc up to the end of @p last, something parsed after its start.
+ */
+static void
+location_extend(const struct pancl_context *ctx, struct pancl_location *loc,
+	const struct pancl_location *last)
+{
+	if (context_tracks_locations(ctx))
+		loc->length = last->offset + last->length - loc->offset;
 }
 
 /**
@@ -113,7 +175,7 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 
 	/* Array should already be initialized, but whatever. */
 	pancl_array_init(array);
-	array->loc = open_bracket->loc;
+	location_set(ctx, NODE_LOCATION(array), &(open_bracket->loc));
 
 	for (;;) {
 		err = next_token(ctx, tb, &t);
@@ -133,14 +195,15 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 			 * allowed.
 			 */
 			if (t.subtype == TST_NEWLINE) {
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_R_BRACKET) {
 				/* Got the ], find that terminator! */
+				location_extend(ctx, NODE_LOCATION(array), &(t.loc));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
@@ -149,7 +212,7 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 				struct pancl_value *v;
 
 				/* Set a fake type for simplicity here. */
-				err = pancl_value_new(&v, PANCL_TYPE_INTEGER);
+				err = pancl_value_new(ctx->pool, &v, PANCL_TYPE_INTEGER);
 
 				if (err != PANCL_SUCCESS)
 					goto cleanup;
@@ -157,16 +220,16 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 				err = parse_rvalue(ctx, tb, &t, v, array_member_terminator);
 
 				if (err == PANCL_SUCCESS)
-					err = pancl_array_append(array, v);
+					err = pancl_array_append(ctx->pool, array, v);
 
 				if (err != PANCL_SUCCESS) {
-					pancl_value_destroy(&v);
+					pancl_value_release(ctx->pool, &v);
 					goto cleanup;
 				}
 			}
 
 			state = FIND_COMMA_OR_R_BRACKET;
-			token_fini(&t);
+			token_fini(ctx, &t);
 			continue;
 
 		case FIND_COMMA_OR_R_BRACKET:
@@ -174,21 +237,22 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 			 * allowed.
 			 */
 			if (t.subtype == TST_NEWLINE) {
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_COMMA) {
 				/* Got a comma, move to another RVALUE or the ']' */
 				state = FIND_RVALUE_OR_R_BRACKET;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_R_BRACKET) {
 				/* Got the ], find that terminator! */
+				location_extend(ctx, NODE_LOCATION(array), &(t.loc));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
@@ -198,7 +262,7 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 				enum terminator_status term = is_terminator(&t);
 
 				if (term == TERM_STATUS_IGNORE) {
-					token_fini(&t);
+					token_fini(ctx, &t);
 					continue;
 				}
 
@@ -224,7 +288,7 @@ parse_array(struct pancl_context *ctx, struct token_buffer *tb,
 	err = PANCL_ERROR_INTERNAL;
 
 cleanup:
-	token_fini(&t);
+	token_fini(ctx, &t);
 	return err;
 }
 
@@ -283,7 +347,7 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 
 	/* Tuple should already be initialized, but whatever. */
 	pancl_tuple_init(tuple);
-	tuple->loc = open_paren->loc;
+	location_set(ctx, NODE_LOCATION(tuple), &(open_paren->loc));
 
 	for (;;) {
 		err = next_token(ctx, tb, &t);
@@ -303,14 +367,15 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 			 * allowed.
 			 */
 			if (t.subtype == TST_NEWLINE) {
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_R_PAREN) {
 				/* Got the ), find that terminator! */
+				location_extend(ctx, NODE_LOCATION(tuple), &(t.loc));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
@@ -319,7 +384,7 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 				struct pancl_value *v;
 
 				/* Set a fake type for simplicity here. */
-				err = pancl_value_new(&v, PANCL_TYPE_INTEGER);
+				err = pancl_value_new(ctx->pool, &v, PANCL_TYPE_INTEGER);
 
 				if (err != PANCL_SUCCESS)
 					goto cleanup;
@@ -327,16 +392,16 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 				err = parse_rvalue(ctx, tb, &t, v, tuple_member_terminator);
 
 				if (err == PANCL_SUCCESS)
-					err = pancl_tuple_append(tuple, v);
+					err = pancl_tuple_append(ctx->pool, tuple, v);
 
 				if (err != PANCL_SUCCESS) {
-					pancl_value_destroy(&v);
+					pancl_value_release(ctx->pool, &v);
 					goto cleanup;
 				}
 			}
 
 			state = FIND_COMMA_OR_R_PAREN;
-			token_fini(&t);
+			token_fini(ctx, &t);
 			continue;
 
 		case FIND_COMMA_OR_R_PAREN:
@@ -344,21 +409,22 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 			 * allowed.
 			 */
 			if (t.subtype == TST_NEWLINE) {
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_COMMA) {
 				/* Got a comma, move to another RVALUE or the ')' */
 				state = FIND_RVALUE_OR_R_PAREN;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_R_PAREN) {
 				/* Got the ), find that terminator */
+				location_extend(ctx, NODE_LOCATION(tuple), &(t.loc));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
@@ -368,7 +434,7 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 				enum terminator_status term = is_terminator(&t);
 
 				if (term == TERM_STATUS_IGNORE) {
-					token_fini(&t);
+					token_fini(ctx, &t);
 					continue;
 				}
 
@@ -394,7 +460,7 @@ parse_tuple(struct pancl_context *ctx, struct token_buffer *tb,
 	err = PANCL_ERROR_INTERNAL;
 
 cleanup:
-	token_fini(&t);
+	token_fini(ctx, &t);
 	return err;
 }
 
@@ -453,7 +519,7 @@ parse_table_data(struct pancl_context *ctx, struct token_buffer *tb,
 
 	/* Table data should already be initialized, but whatever. */
 	pancl_table_data_init(table_data);
-	table_data->loc = open_brace->loc;
+	location_set(ctx, NODE_LOCATION(table_data), &(open_brace->loc));
 
 	for (;;) {
 		err = next_token(ctx, tb, &t);
@@ -471,14 +537,15 @@ parse_table_data(struct pancl_context *ctx, struct token_buffer *tb,
 		case FIND_ASSIGNMENT_OR_R_BRACE:
 			/* When searching for an assignment, newlines are allowed. */
 			if (t.subtype == TST_NEWLINE) {
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_R_BRACE) {
 				/* Got the }, find that newline! */
+				location_extend(ctx, NODE_LOCATION(table_data), &(t.loc));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
@@ -490,15 +557,15 @@ parse_table_data(struct pancl_context *ctx, struct token_buffer *tb,
 
 				/* On success we append to the entry to the table.*/
 				if (err == PANCL_SUCCESS)
-					err = pancl_table_data_append(table_data, entry);
+					err = pancl_table_data_append(ctx->pool, table_data, entry);
 
 				if (err != PANCL_SUCCESS) {
-					pancl_entry_destroy(&entry);
+					pancl_entry_release(ctx->pool, &entry);
 					goto cleanup;
 				}
 
 				state = FIND_COMMA_OR_R_BRACE;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
@@ -508,21 +575,22 @@ parse_table_data(struct pancl_context *ctx, struct token_buffer *tb,
 			 * allowed.
 			 */
 			if (t.subtype == TST_NEWLINE) {
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_COMMA) {
 				/* Got a comma, move to another assignment or the '}' */
 				state = FIND_ASSIGNMENT_OR_R_BRACE;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 
 			if (t.type == TT_R_BRACE) {
 				/* Got the }, find that terminator! */
+				location_extend(ctx, NODE_LOCATION(table_data), &(t.loc));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
@@ -532,7 +600,7 @@ parse_table_data(struct pancl_context *ctx, struct token_buffer *tb,
 				enum terminator_status term = is_terminator(&t);
 
 				if (term == TERM_STATUS_IGNORE) {
-					token_fini(&t);
+					token_fini(ctx, &t);
 					continue;
 				}
 
@@ -558,7 +626,7 @@ parse_table_data(struct pancl_context *ctx, struct token_buffer *tb,
 	err = PANCL_ERROR_INTERNAL;
 
 cleanup:
-	token_fini(&t);
+	token_fini(ctx, &t);
 	return err;
 }
 
@@ -579,9 +647,11 @@ parse_custom_type(struct pancl_context *ctx, struct token_buffer *tb,
 	int err;
 	struct token t = TOKEN_INIT;
 
-	custom->loc = name->loc;
-	custom->name = name->string;
-	name->string = NULL; /* Owned by custom now */
+	location_set(ctx, NODE_LOCATION(custom), &(name->loc));
+	err = token_take_string(ctx, name, STRING_KEY, &(custom->name));
+
+	if (err != PANCL_SUCCESS)
+		return err;
 
 	for (;;) {
 		err = next_token(ctx, tb, &t);
@@ -603,6 +673,8 @@ parse_custom_type(struct pancl_context *ctx, struct token_buffer *tb,
 
 		if (t.type == TT_L_PAREN) {
 			err = parse_tuple(ctx, tb, &t, &(custom->tuple), is_terminator);
+			location_extend(ctx, NODE_LOCATION(custom),
+					NODE_LOCATION(&(custom->tuple)));
 			goto cleanup;
 		}
 
@@ -616,7 +688,280 @@ parse_custom_type(struct pancl_context *ctx, struct token_buffer *tb,
 	err = PANCL_ERROR_INTERNAL;
 
 cleanup:
-	token_fini(&t);
+	token_fini(ctx, &t);
+	return err;
+}
+
+/**
+ * Whether a token can start an RVALUE.
+ */
+static bool
+is_rvalue_start(const struct token * const t)
+{
+	switch (t->type) {
+	case TT_STRING:
+	case TT_INT_BIN:
+	case TT_INT_DEC:
+	case TT_INT_HEX:
+	case TT_INT_OCT:
+	case TT_FLOAT:
+	case TT_TRUE:
+	case TT_FALSE:
+	case TT_L_BRACKET:
+	case TT_L_PAREN:
+	case TT_L_BRACE:
+	case TT_RAW_IDENT:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * Whether a raw identifier names the ::Float custom type.
+ */
+static bool
+is_float_type(const struct token * const t)
+{
+	size_t bytes;
+	const char *text = token_text(t, &bytes);
+
+	return bytes == 7 && memcmp(text, "::Float", 7) == 0;
+}
+
+/**
+ * Handle the ::Float custom type:
+ *
+ * FloatType = '::Float' '(' string ')'
+ *           | '::Float' '(' string ',' ')'
+ *           | '::Float' '(' string ',' integer ')'
+ *           | '::Float' '(' string ',' integer ',' ')'
+ *           ;
+ *
+ * This is the same syntax as any other CustomType, but the arguments are
+ * converted straight from their tokens into a PANCL_TYPE_FLOATING value
+ * instead of being built into a tuple first.  The optional integer is the
+ * base, see str_to_double_base().
+ *
+ * The raw_identifier portion is handled by the caller so we start parsing
+ * with the '('.
+ */
+static int
+parse_float_type(struct pancl_context *ctx, struct token_buffer *tb,
+	struct token *name, struct pancl_value *value,
+	terminator_fn is_terminator)
+{
+	int err;
+	struct token t = TOKEN_INIT;
+	struct token string = TOKEN_INIT;
+	struct pancl_location loc = name->loc;
+	int base = 0;
+
+	enum {
+		FIND_L_PAREN,
+		FIND_STRING,
+		/* After the string. */
+		FIND_COMMA_OR_R_PAREN,
+		FIND_BASE_OR_R_PAREN,
+		/* After the base. */
+		FIND_LAST_COMMA_OR_R_PAREN,
+		FIND_R_PAREN,
+		FIND_TERMINATOR
+	} state;
+
+	state = FIND_L_PAREN;
+
+	for (;;) {
+		err = next_token(ctx, tb, &t);
+
+		if (err != PANCL_SUCCESS)
+			goto cleanup;
+
+		if (t.type == TT_ERROR) {
+			context_set_error(ctx, &t);
+			err = PANCL_ERROR_PARSER_TOKEN;
+			goto cleanup;
+		}
+
+		switch (state) {
+		case FIND_L_PAREN:
+			if (t.type == TT_L_PAREN) {
+				state = FIND_STRING;
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			context_set_error(ctx, &t);
+			err = (t.type == TT_EOF)
+				? PANCL_ERROR_PARSER_EOF
+				: PANCL_ERROR_PARSER_CUSTOM_ARGS;
+			goto cleanup;
+
+		case FIND_STRING:
+			/* Newlines are allowed anywhere between the parens. */
+			if (t.subtype == TST_NEWLINE) {
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (t.type == TT_STRING) {
+				/* Converted once the base is known. */
+				token_move(&string, &t);
+				state = FIND_COMMA_OR_R_PAREN;
+				continue;
+			}
+
+			if (t.type == TT_R_PAREN) {
+				context_set_error(ctx, &t);
+				err = PANCL_ERROR_OPT_FLOAT_ARG_COUNT;
+				goto cleanup;
+			}
+
+			if (is_rvalue_start(&t)) {
+				context_set_error(ctx, &t);
+				err = PANCL_ERROR_OPT_FLOAT_ARG_0_NOT_STRING;
+				goto cleanup;
+			}
+			break;
+
+		case FIND_COMMA_OR_R_PAREN:
+		case FIND_LAST_COMMA_OR_R_PAREN:
+			if (t.subtype == TST_NEWLINE) {
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (t.type == TT_COMMA) {
+				state = (state == FIND_COMMA_OR_R_PAREN)
+					? FIND_BASE_OR_R_PAREN
+					: FIND_R_PAREN;
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (t.type == TT_R_PAREN) {
+				location_extend(ctx, &loc, &(t.loc));
+				state = FIND_TERMINATOR;
+				token_fini(ctx, &t);
+				continue;
+			}
+			break;
+
+		case FIND_BASE_OR_R_PAREN:
+			if (t.subtype == TST_NEWLINE) {
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (t.type == TT_INT_BIN || t.type == TT_INT_DEC
+					|| t.type == TT_INT_HEX || t.type == TT_INT_OCT) {
+				if (t.number.error != PANCL_SUCCESS) {
+					context_set_error(ctx, &t);
+					err = t.number.error;
+					goto cleanup;
+				}
+
+				/* Checked here, while the base token is at hand. */
+				if (t.number.value.integer != 0
+						&& t.number.value.integer != 10
+						&& t.number.value.integer != 16) {
+					context_set_error(ctx, &t);
+					err = PANCL_ERROR_STR_TO_FLOAT_BASE;
+					goto cleanup;
+				}
+
+				base = (int)t.number.value.integer;
+				state = FIND_LAST_COMMA_OR_R_PAREN;
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (t.type == TT_R_PAREN) {
+				location_extend(ctx, &loc, &(t.loc));
+				state = FIND_TERMINATOR;
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (is_rvalue_start(&t)) {
+				context_set_error(ctx, &t);
+				err = PANCL_ERROR_OPT_FLOAT_ARG_1_NOT_INT;
+				goto cleanup;
+			}
+			break;
+
+		case FIND_R_PAREN:
+			if (t.subtype == TST_NEWLINE) {
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (t.type == TT_R_PAREN) {
+				location_extend(ctx, &loc, &(t.loc));
+				state = FIND_TERMINATOR;
+				token_fini(ctx, &t);
+				continue;
+			}
+
+			if (is_rvalue_start(&t)) {
+				context_set_error(ctx, &t);
+				err = PANCL_ERROR_OPT_FLOAT_ARG_COUNT;
+				goto cleanup;
+			}
+			break;
+
+		case FIND_TERMINATOR:
+			{
+				enum terminator_status term = is_terminator(&t);
+
+				if (term == TERM_STATUS_IGNORE) {
+					token_fini(ctx, &t);
+					continue;
+				}
+
+				if (term == TERM_STATUS_VALID) {
+					double d;
+					size_t bytes;
+					const char *text = token_text(&string, &bytes);
+
+					err = lexer_rewind_token(ctx, &t);
+
+					if (err != PANCL_SUCCESS)
+						goto cleanup;
+
+					err = str_to_double_base(&d, text, bytes, base);
+
+					if (err != PANCL_SUCCESS) {
+						context_set_error(ctx, &string);
+						goto cleanup;
+					}
+
+					pancl_value_init(value, PANCL_TYPE_FLOATING);
+					location_set(ctx, NODE_LOCATION(value), &loc);
+					value->data.floating = d;
+					goto cleanup;
+				}
+			}
+			break;
+		}
+
+		/* Got anything else: invalid parse. */
+		context_set_error(ctx, &t);
+
+		if (t.type == TT_EOF)
+			err = PANCL_ERROR_PARSER_EOF;
+		else
+			err = PANCL_ERROR_PARSER_TUPLE;
+		goto cleanup;
+	}
+
+	/* We shouldn't be able to get here. */
+	err = PANCL_ERROR_INTERNAL;
+
+cleanup:
+	token_fini(ctx, &string);
+	token_fini(ctx, &t);
 	return err;
 }
 
@@ -642,94 +987,110 @@ parse_rvalue(struct pancl_context *ctx, struct token_buffer *tb,
 	struct token *start, struct pancl_value *value,
 	terminator_fn is_terminator)
 {
-	value->loc = start->loc;
+	int err = PANCL_SUCCESS;
 
 	switch (start->type) {
 	case TT_STRING:
 		pancl_value_init(value, PANCL_TYPE_STRING);
-		value->data.string = start->string;
-		start->string = NULL; /* Owned by value now. */
-		return PANCL_SUCCESS;
+		/* Owned by value now. */
+		err = token_take_string(ctx, start, STRING_VALUE,
+				&(value->data.string));
+		break;
 
+	/* Numbers were converted by the lexer already. */
 	case TT_INT_BIN:
-		pancl_value_init(value, PANCL_TYPE_INTEGER);
-		return str_to_int32(&(value->data.integer), start->string->data, 2);
-
 	case TT_INT_DEC:
-		{
-			/* XXX: Hack! Since the lexer can pick up a number with leading
-			 *      zeros as a decimal, we have to validate here that it's
-			 *      legal.
-			 *
-			 *      This should probably be done in the lexer but that code is
-			 *      so clean that I don't want to muddy it.
-			 */
-			const char *p = start->string->data;
-			if (*p == '-' || *p == '+')
-				++p;
-			if (p[0] == '0' && p[1] != '\0')
-				return PANCL_ERROR_INT_LEADING_ZEROS;
-		}
-		pancl_value_init(value, PANCL_TYPE_INTEGER);
-		return str_to_int32(&(value->data.integer), start->string->data, 10);
-
 	case TT_INT_HEX:
-		pancl_value_init(value, PANCL_TYPE_INTEGER);
-		return str_to_int32(&(value->data.integer), start->string->data, 16);
-
 	case TT_INT_OCT:
+		if (start->number.error != PANCL_SUCCESS)
+			return start->number.error;
+
 		pancl_value_init(value, PANCL_TYPE_INTEGER);
-		return str_to_int32(&(value->data.integer), start->string->data, 8);
+		value->data.integer = start->number.value.integer;
+		break;
 
 	case TT_FLOAT:
-		/* XXX Should implement our own strtod(). */
+		if (start->number.error != PANCL_SUCCESS)
+			return start->number.error;
+
 		pancl_value_init(value, PANCL_TYPE_FLOATING);
-		value->data.floating = strtod(start->string->data, NULL);
-		return PANCL_SUCCESS;
+		value->data.floating = start->number.value.floating;
+		break;
 
 	case TT_TRUE:
 		pancl_value_init(value, PANCL_TYPE_BOOLEAN);
 		value->data.boolean = 1;
-		return PANCL_SUCCESS;
+		break;
 
 	case TT_FALSE:
 		pancl_value_init(value, PANCL_TYPE_BOOLEAN);
 		value->data.boolean = 0;
-		return PANCL_SUCCESS;
+		break;
 
 	case TT_L_BRACKET: /* Array start */
-		pancl_value_init(value, PANCL_TYPE_ARRAY);
-		return parse_array(ctx, tb, start, &(value->data.array),
-					is_terminator);
+		err = pancl_value_init_data(ctx->pool, value, PANCL_TYPE_ARRAY);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+
+		err = parse_array(ctx, tb, start, pancl_value_array(value),
+				is_terminator);
+		location_set(ctx, NODE_LOCATION(value),
+				NODE_LOCATION(pancl_value_array(value)));
+		return err;
 
 	case TT_L_PAREN: /* Tuple start */
-		pancl_value_init(value, PANCL_TYPE_TUPLE);
-		return parse_tuple(ctx, tb, start, &(value->data.tuple),
-					is_terminator);
+		err = pancl_value_init_data(ctx->pool, value, PANCL_TYPE_TUPLE);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+
+		err = parse_tuple(ctx, tb, start, pancl_value_tuple(value),
+				is_terminator);
+		location_set(ctx, NODE_LOCATION(value),
+				NODE_LOCATION(pancl_value_tuple(value)));
+		return err;
 
 	case TT_L_BRACE: /* Table start */
-		pancl_value_init(value, PANCL_TYPE_TABLE);
-		return parse_table_data(ctx, tb, start, &(value->data.table),
-					is_terminator);
+		err = pancl_value_init_data(ctx->pool, value, PANCL_TYPE_TABLE);
 
-	case TT_RAW_IDENT: /* Custom type start */
-		pancl_value_init(value, PANCL_TYPE_CUSTOM);
-		{
-			int err;
+		if (err != PANCL_SUCCESS)
+			return err;
 
-			err = parse_custom_type(ctx, tb, start, &(value->data.custom),
-					is_terminator);
+		err = parse_table_data(ctx, tb, start, pancl_value_table(value),
+				is_terminator);
+		location_set(ctx, NODE_LOCATION(value),
+				NODE_LOCATION(pancl_value_table(value)));
+		return err;
+
+	case TT_RAW_IDENT: /* Custom type start */
+		if (is_float_type(start))
+			return parse_float_type(ctx, tb, start, value, is_terminator);
 
-			if (err == PANCL_SUCCESS)
-				err = handle_known_custom_types(value);
+		err = pancl_value_init_data(ctx->pool, value, PANCL_TYPE_CUSTOM);
 
+		if (err != PANCL_SUCCESS)
 			return err;
-		}
-		break;
+
+		err = parse_custom_type(ctx, tb, start, pancl_value_custom(value),
+				is_terminator);
+		location_set(ctx, NODE_LOCATION(value),
+				NODE_LOCATION(pancl_value_custom(value)));
+
+		if (err == PANCL_SUCCESS)
+			err = handle_known_custom_types(ctx->pool, value);
+
+		return err;
 
 	default:
 		return PANCL_ERROR_PARSER_RVALUE;
 	}
+
+	/* Scalars span just their token.  Initializing the value cleared its
+	 * location, so it's set last.
+	 */
+	location_set(ctx, NODE_LOCATION(value), &(start->loc));
+	return err;
 }
 
 
@@ -760,15 +1121,19 @@ parse_assignment(struct pancl_context *ctx, struct token_buffer *tb,
 
 	state = FIND_EQ;
 
-	err = pancl_entry_new(entry_storage);
+	err = pancl_entry_new(ctx->pool, entry_storage);
 
 	if (err != PANCL_SUCCESS)
 		return err;
 
 	/* Grab the starting token's location and string value. */
-	entry_storage[0]->loc = name->loc;
-	entry_storage[0]->name = name->string;
-	name->string = NULL; /* Owned by *entry_storage now. */
+	location_set(ctx, NODE_LOCATION(entry_storage[0]), &(name->loc));
+	/* Owned by *entry_storage now. */
+	err = token_take_string(ctx, name, STRING_KEY,
+			&(entry_storage[0]->name));
+
+	if (err != PANCL_SUCCESS)
+		goto cleanup;
 
 	for (;;) {
 		err = next_token(ctx, tb, &t);
@@ -786,7 +1151,7 @@ parse_assignment(struct pancl_context *ctx, struct token_buffer *tb,
 		case FIND_EQ:
 			if (t.type == TT_EQ) {
 				state = FIND_RVALUE;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
@@ -797,8 +1162,10 @@ parse_assignment(struct pancl_context *ctx, struct token_buffer *tb,
 					is_terminator);
 
 			if (err == PANCL_SUCCESS) {
+				location_extend(ctx, NODE_LOCATION(entry_storage[0]),
+						NODE_LOCATION(&(entry_storage[0]->value)));
 				state = FIND_TERMINATOR;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			goto cleanup;
@@ -808,7 +1175,7 @@ parse_assignment(struct pancl_context *ctx, struct token_buffer *tb,
 				enum terminator_status term = is_terminator(&t);
 
 				if (term == TERM_STATUS_IGNORE) {
-					token_fini(&t);
+					token_fini(ctx, &t);
 					continue;
 				}
 
@@ -838,9 +1205,9 @@ parse_assignment(struct pancl_context *ctx, struct token_buffer *tb,
 
 cleanup:
 	if (err != PANCL_SUCCESS)
-		pancl_entry_destroy(entry_storage);
+		pancl_entry_release(ctx->pool, entry_storage);
 
-	token_fini(&t);
+	token_fini(ctx, &t);
 	return err;
 }
 
@@ -856,7 +1223,7 @@ cleanup:
  */
 static int
 parse_table_header(struct pancl_context *ctx, struct token_buffer *tb,
-	struct pancl_utf8_string **name_storage)
+	struct pancl_table *table)
 {
 	int err;
 	struct token t = TOKEN_INIT;
@@ -888,18 +1255,21 @@ parse_table_header(struct pancl_context *ctx, struct token_buffer *tb,
 			if (t.subtype == TST_IDENT) {
 				state = FIND_R_BRACKET;
 
-				*name_storage = t.string;
-				t.string = NULL;
+				err = token_take_string(ctx, &t, STRING_KEY, &(table->name));
 
-				token_fini(&t);
+				if (err != PANCL_SUCCESS)
+					goto cleanup;
+
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
 
 		case FIND_R_BRACKET:
 			if (t.type == TT_R_BRACKET) {
+				location_extend(ctx, NODE_LOCATION(table), &(t.loc));
 				state = FIND_NEWLINE;
-				token_fini(&t);
+				token_fini(ctx, &t);
 				continue;
 			}
 			break;
@@ -909,7 +1279,7 @@ parse_table_header(struct pancl_context *ctx, struct token_buffer *tb,
 				enum terminator_status term = newline_terminator(&t);
 
 				if (term == TERM_STATUS_IGNORE) {
-					token_fini(&t);
+					token_fini(ctx, &t);
 					continue;
 				}
 
@@ -935,7 +1305,7 @@ parse_table_header(struct pancl_context *ctx, struct token_buffer *tb,
 	err = PANCL_ERROR_INTERNAL;
 
 cleanup:
-	token_fini(&t);
+	token_fini(ctx, &t);
 	return err;
 }
 
@@ -949,7 +1319,7 @@ cleanup:
 int
 pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 {
-	struct token_buffer tb = TOKEN_BUFFER_INIT;
+	struct token_buffer *tb;
 	struct token t = TOKEN_INIT;
 
 	int err;
@@ -958,12 +1328,60 @@ pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 		return PANCL_ERROR_ARG_INVALID;
 
 	/* Make sure the error token is cleared so we can safely replace it. */
-	pancl_utf8_string_destroy(&(ctx->error_token));
+	pancl_context_clear_error(ctx);
+
+	/* The token buffer lives as long as the context so its storage is
+	 * reused for every table.
+	 */
+	if (ctx->token_buffer == NULL) {
+		ctx->token_buffer = pancl_allocator_alloc(&(ctx->allocator),
+			sizeof(*tb));
+
+		if (ctx->token_buffer == NULL)
+			return PANCL_ERROR_ALLOC;
+
+		token_buffer_init(ctx->token_buffer);
+	}
+
+	tb = ctx->token_buffer;
+
+	/* Nodes are allocated through the pool, so one is needed even when it
+	 * only passes them on to the allocator.
+	 */
+	if (ctx->pool == NULL) {
+		err = pancl_pool_new(&(ctx->pool), &(ctx->allocator), ctx->flags);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
+	else if (pancl_pool_is_arena(ctx->pool)
+			&& !pancl_pool_is_shared(ctx->pool)) {
+		/* No tables from earlier calls are alive anymore, so their memory
+		 * can be handed out again.
+		 */
+		pancl_pool_reset(ctx->pool);
+	}
+
+	tb->pool = ctx->pool;
 
 	pancl_table_init(table);
 
+	/* Only arenas, free lists and interned strings tie a table to the
+	 * context's pool.  Otherwise it just needs the allocator, so tables
+	 * don't share anything and can be released independently.
+	 */
+	if (!pancl_pool_is_plain(ctx->pool)) {
+		table->pool = pancl_pool_ref(ctx->pool);
+	}
+	else if (!pancl_allocator_is_default(&(ctx->allocator))) {
+		err = pancl_pool_new(&(table->pool), &(ctx->allocator), 0);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
+
 	for (;;) {
-		err = next_token(ctx, &tb, &t);
+		err = next_token(ctx, tb, &t);
 
 		if (err != PANCL_SUCCESS)
 			goto cleanup;
@@ -991,7 +1409,7 @@ pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 		 *  TT_NEWLINE, TT_COMMENT
 		 */
 		if (t.subtype == TST_NEWLINE) {
-			token_fini(&t);
+			token_fini(ctx, &t);
 			continue;
 		}
 
@@ -999,18 +1417,30 @@ pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 		if (t.subtype == TST_IDENT) {
 			struct pancl_entry *entry = NULL;
 
-			err = parse_assignment(ctx, &tb, &t, &entry, newline_terminator);
+			err = parse_assignment(ctx, tb, &t, &entry, newline_terminator);
 
-			/* On success we append to the entry to the table.*/
-			if (err == PANCL_SUCCESS)
-				err = pancl_table_data_append(&(table->data), entry);
+			/* The table runs up to its last entry, and without a header
+			 * it starts with the first one.
+			 */
+			if (err == PANCL_SUCCESS) {
+				if (pancl_string_is_null(&(table->name))
+						&& table->data.count == 0)
+					location_set(ctx, NODE_LOCATION(table),
+							NODE_LOCATION(entry));
+				else
+					location_extend(ctx, NODE_LOCATION(table),
+							NODE_LOCATION(entry));
+
+				err = pancl_table_data_append(ctx->pool, &(table->data),
+						entry);
+			}
 
 			if (err != PANCL_SUCCESS) {
-				pancl_entry_destroy(&entry);
+				pancl_entry_release(ctx->pool, &entry);
 				goto cleanup;
 			}
 
-			token_fini(&t);
+			token_fini(ctx, &t);
 			continue;
 		}
 
@@ -1020,7 +1450,8 @@ pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 			 * return the table.  We'll start here again on the next
 			 * round.
 			 */
-			if (table->name != NULL || table->data.count != 0) {
+			if (!pancl_string_is_null(&(table->name))
+					|| table->data.count != 0) {
 				err = lexer_rewind_token(ctx, &t);
 
 				if (err != PANCL_SUCCESS)
@@ -1030,13 +1461,13 @@ pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 			}
 
 			/* Store the location of the start of the table. */
-			table->loc = t.loc;
-			err = parse_table_header(ctx, &tb, &(table->name));
+			location_set(ctx, NODE_LOCATION(table), &(t.loc));
+			err = parse_table_header(ctx, tb, table);
 
 			if (err != PANCL_SUCCESS)
 				goto cleanup;
 
-			token_fini(&t);
+			token_fini(ctx, &t);
 			continue;
 		}
 
@@ -1051,17 +1482,32 @@ pancl_get_next_table(struct pancl_context *ctx, struct pancl_table *table)
 	 * If table name == NULL and table has no entries, this is the end of the
 	 * input.
 	 */
-	if (table->name == NULL && table->data.count == 0)
+	if (pancl_string_is_null(&(table->name)) && table->data.count == 0) {
 		err = PANCL_END_OF_INPUT;
-	else
+	}
+	else {
+		/* Nothing delimits the data of a top level table but the table
+		 * itself.
+		 */
+		location_set(ctx, NODE_LOCATION(&(table->data)),
+			NODE_LOCATION(table));
 		err = PANCL_SUCCESS;
+	}
 
 cleanup:
+	/* Without locations nothing recorded where a failure was, but the
+	 * lexer stopped right after it.
+	 */
+	if (err != PANCL_SUCCESS && err != PANCL_END_OF_INPUT
+			&& !context_tracks_locations(ctx))
+		ctx->error_loc = lexer_location(ctx);
+
 	if (err != PANCL_SUCCESS)
 		pancl_table_fini(table);
 
-	token_buffer_fini(&tb);
-	token_fini(&t);
+	/* Whatever was left over still belongs to the pool. */
+	token_buffer_reset(tb);
+	token_fini(ctx, &t);
 	return err;
 }
 
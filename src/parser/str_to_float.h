@@ -0,0 +1,11 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef H_PANCL_PARSE_STR_TO_FLOAT
+#define H_PANCL_PARSE_STR_TO_FLOAT
+
+#include <stddef.h>
+
+int str_to_double(double *ret, const char *str, size_t len);
+int str_to_double_base(double *ret, const char *str, size_t len, int base);
+
+#endif /* H_PANCL_PARSE_STR_TO_FLOAT */
+// vim:ts=4:sw=4:autoindent
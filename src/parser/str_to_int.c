@@ -2,17 +2,280 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "pancl/pancl.h"
 #include "parser/str_to_int.h"
 
+/**
+ * @file str_to_int.c
+ * @brief String to fixed width integer conversion.
+ *
+ * Decimal and hexadecimal digits are converted eight at a time, as the bytes
+ * of a single 64-bit integer (SWAR), and the other power of two bases with
+ * shifts.  Everything is inlined into the str_to_*() functions so each one is
+ * specialized for the limits of its width.
+ */
+
+/**
+ * Every byte set to 1, times a byte value repeats it across a uint64_t.
+ */
+#define SWAR_ONES  UINT64_C(0x0101010101010101)
+#define SWAR_HIGH  (SWAR_ONES * 0x80)
+
+/**
+ * Loads 8 bytes, the first one into the lowest byte.
+ */
+static inline uint64_t
+load_le64(const char *p)
+{
+	const unsigned char *u = (const unsigned char *)p;
+
+	return (uint64_t)u[0]
+		| ((uint64_t)u[1] << 8)
+		| ((uint64_t)u[2] << 16)
+		| ((uint64_t)u[3] << 24)
+		| ((uint64_t)u[4] << 32)
+		| ((uint64_t)u[5] << 40)
+		| ((uint64_t)u[6] << 48)
+		| ((uint64_t)u[7] << 56);
+}
+
+/**
+ * Whether all 8 bytes of @p chunk are in [0-9].
+ */
+static inline bool
+swar_is_dec8(uint64_t chunk)
+{
+	/* High nibbles must be 3, and adding 6 mustn't carry out of the low
+	 * nibble.
+	 */
+	return ((chunk & (SWAR_ONES * 0xf0))
+		| (((chunk + SWAR_ONES * 0x06) & (SWAR_ONES * 0xf0)) >> 4))
+		== SWAR_ONES * 0x33;
+}
+
+/**
+ * Value of 8 decimal digits, merging neighbouring digits, then pairs, then
+ * quads with one multiplication each.
+ */
+static inline uint32_t
+swar_dec8(uint64_t chunk)
+{
+	chunk = ((chunk & (SWAR_ONES * 0x0f)) * (10 * 0x100 + 1)) >> 8;
+	chunk = ((chunk & UINT64_C(0x00ff00ff00ff00ff))
+			* (100 * UINT64_C(0x10000) + 1)) >> 16;
+	return (uint32_t)(((chunk & UINT64_C(0x0000ffff0000ffff))
+			* (10000 * UINT64_C(0x100000000) + 1)) >> 32);
+}
+
+/**
+ * Value of 8 hexadecimal digits, if all 8 bytes of @p chunk are in
+ * [0-9a-fA-F].
+ */
+static inline bool
+swar_hex8(uint64_t chunk, uint32_t *value)
+{
+	uint64_t lower = chunk | (SWAR_ONES * 0x20);
+	uint64_t digit;
+	uint64_t letter;
+
+	/* With the high bits clear, each byte can be compared in place: adding
+	 * (0x80 - lo) sets the high bit for bytes >= lo, subtracting from
+	 * (0x80 + hi) for bytes <= hi.  Neither carries into the next byte.
+	 */
+	if ((chunk & SWAR_HIGH) != 0)
+		return false;
+
+	digit = (chunk + SWAR_ONES * (0x80 - '0'))
+		& (SWAR_ONES * (0x80 + '9') - chunk);
+	letter = (lower + SWAR_ONES * (0x80 - 'a'))
+		& (SWAR_ONES * (0x80 + 'f') - lower);
+
+	if (((digit | letter) & SWAR_HIGH) != SWAR_HIGH)
+		return false;
+
+	/* Nibble values: the low nibble, plus 9 for letters. */
+	chunk = (chunk & (SWAR_ONES * 0x0f)) + ((letter & SWAR_HIGH) >> 7) * 9;
+
+	/* Merge the same way as swar_dec8(). */
+	chunk = ((chunk * (16 * 0x100 + 1)) >> 8) & UINT64_C(0x00ff00ff00ff00ff);
+	chunk = ((chunk * (256 * UINT64_C(0x10000) + 1)) >> 16)
+		& UINT64_C(0x0000ffff0000ffff);
+	*value = (uint32_t)((chunk * (65536 * UINT64_C(0x100000000) + 1)) >> 32);
+	return true;
+}
+
+/**
+ * Value of @p c as a digit in any base up to 36, or -1.
+ */
+static inline int
+digit_value(char c)
+{
+	unsigned int u = (unsigned char)c;
+
+	if (u - '0' < 10)
+		return (int)(u - '0');
+
+	u |= 0x20;
+
+	if (u - 'a' < 26)
+		return (int)(u - 'a' + 10);
+
+	return -1;
+}
+
+/**
+ * Number of decimal digits in @p max.
+ */
+static inline size_t
+dec_digits(uint64_t max)
+{
+	size_t n = 1;
+
+	for (; max >= 10; max /= 10)
+		++n;
+
+	return n;
+}
+
+/* The parse_*() functions convert [str, end) in one base.  Like a digit by
+ * digit conversion, they report PANCL_ERROR_STR_TO_INT_RANGE if the value
+ * exceeds @p max before reaching an invalid character, and
+ * PANCL_ERROR_STR_TO_INT_CHAR otherwise.
+ */
+
+static inline int
+parse_dec(uint64_t *ret, uint64_t max, const char *str, const char *end)
+{
+	const char *digits;
+	const char *p;
+	uint64_t r = 0;
+	size_t n;
+
+	/* Leading zeros don't change the value. */
+	while (str < end && *str == '0')
+		++str;
+
+	for (digits = str; end - str >= 8 && swar_is_dec8(load_le64(str));)
+		str += 8;
+
+	while (str < end && *str >= '0' && *str <= '9')
+		++str;
+
+	/* Having more digits than max means being larger than it. */
+	n = (size_t)(str - digits);
+
+	if (n > dec_digits(max))
+		return PANCL_ERROR_STR_TO_INT_RANGE;
+
+	/* Up to 19 digits fit in 64 bits. */
+	for (p = digits; n >= 8 && p - digits <= 19 - 8; n -= 8, p += 8)
+		r = r * 100000000 + swar_dec8(load_le64(p));
+
+	for (; n > 0 && p - digits < 19; --n, ++p)
+		r = r * 10 + (uint64_t)(*p - '0');
+
+	if (n > 0) {
+		/* The 20th digit of a 64-bit maximum. */
+		uint64_t v = (uint64_t)(*p - '0');
+
+		if (r > max / 10 || (r == max / 10 && v > max % 10))
+			return PANCL_ERROR_STR_TO_INT_RANGE;
+
+		r = r * 10 + v;
+	}
+	else if (r > max) {
+		return PANCL_ERROR_STR_TO_INT_RANGE;
+	}
+
+	if (str != end)
+		return PANCL_ERROR_STR_TO_INT_CHAR;
+
+	*ret = r;
+	return PANCL_SUCCESS;
+}
+
+static inline int
+parse_pow2(uint64_t *ret, uint64_t max, const char *str, const char *end,
+	unsigned int shift)
+{
+	uint64_t r = 0;
+
+	while (str < end && *str == '0')
+		++str;
+
+	if (shift == 4) {
+		uint32_t v;
+
+		for (; end - str >= 8 && swar_hex8(load_le64(str), &v); str += 8) {
+			if ((r >> 32) != 0)
+				return PANCL_ERROR_STR_TO_INT_RANGE;
+
+			r = (r << 32) | v;
+		}
+	}
+
+	for (; str < end; ++str) {
+		int v = digit_value(*str);
+
+		if (v < 0 || v >= (1 << shift))
+			break;
+
+		/* Shifting out any bits would overflow. */
+		if ((r >> (64 - shift)) != 0)
+			return PANCL_ERROR_STR_TO_INT_RANGE;
+
+		r = (r << shift) | (uint64_t)v;
+	}
+
+	if (r > max)
+		return PANCL_ERROR_STR_TO_INT_RANGE;
+
+	if (str != end)
+		return PANCL_ERROR_STR_TO_INT_CHAR;
+
+	*ret = r;
+	return PANCL_SUCCESS;
+}
+
 static int
-str_to_uintmax_internal(uintmax_t *ret, uintmax_t max, const char *str,
+parse_any(uint64_t *ret, uint64_t max, const char *str, const char *end,
 	int base)
 {
-	uintmax_t r = 0;
-	uintmax_t mul_max;
-	uintmax_t add_max;
+	uint64_t r = 0;
+	uint64_t mul_max = max / (uint64_t)base; /* Maximum for multiplication */
+	uint64_t add_max = max % (uint64_t)base; /* Max to add if at mul_max */
+
+	for (; str < end; ++str) {
+		int v = digit_value(*str);
+
+		/* Invalid character in string:
+		 *   Either a character not in [0-9a-zA-Z]
+		 *   Or the character is invalid for the given base.
+		 */
+		if (v < 0 || v >= base)
+			return PANCL_ERROR_STR_TO_INT_CHAR;
+
+		/* If multiplication would cause an overflow. */
+		if (r > mul_max)
+			return PANCL_ERROR_STR_TO_INT_RANGE;
+
+		/* If addition would cause an overflow. */
+		if (r == mul_max && (uint64_t)v > add_max)
+			return PANCL_ERROR_STR_TO_INT_RANGE;
+
+		r = (r * (uint64_t)base) + (uint64_t)v;
+	}
+
+	*ret = r;
+	return PANCL_SUCCESS;
+}
+
+static inline int
+str_to_uint_internal(uint64_t *ret, uint64_t max, const char *str, int base)
+{
+	const char *end;
 
 	if (base < 0 || base == 1 || base > 36)
 		return PANCL_ERROR_STR_TO_INT_BASE;
@@ -28,11 +291,6 @@ str_to_uintmax_internal(uintmax_t *ret, uintmax_t max, const char *str,
 	 */
 
 	if (str[0] == '0') {
-		if (str[1] == '\0') {
-			*ret = 0;
-			return PANCL_SUCCESS;
-		}
-
 		switch (str[1]) {
 		case '\0':
 			*ret = 0;
@@ -67,55 +325,42 @@ str_to_uintmax_internal(uintmax_t *ret, uintmax_t max, const char *str,
 		}
 	}
 
-	if (base == 0)
-		base = 10;
+	end = str + strlen(str);
 
-	mul_max = max / base; /* Maximum for multiplication */
-	add_max = max % base; /* Max allowed to add if at mul_max */
+	switch (base) {
+	case 0:
+	case 10:
+		return parse_dec(ret, max, str, end);
 
-	/* Base cannot be 0 here so we can handle things pretty normally. */
-	for (;*str != '\0'; ++str) {
-		int v;
+	case 2:
+		return parse_pow2(ret, max, str, end, 1);
 
-		/* Invalid character in string:
-		 *   Either a character not in [0-9a-zA-Z]
-		 *   Or the character is invalid for the given base.
-		 */
+	case 4:
+		return parse_pow2(ret, max, str, end, 2);
 
-		if (*str >= '0' && *str <= '9')
-			v = *str - '0';
-		else if (*str >= 'a' && *str <= 'z')
-			v = *str - 'a' + 10;
-		else if (*str >= 'A' && *str <= 'Z')
-			v = *str - 'A' + 10;
-		else
-			return PANCL_ERROR_STR_TO_INT_CHAR;
-
-		if (v >= base)
-			return PANCL_ERROR_STR_TO_INT_CHAR;
+	case 8:
+		return parse_pow2(ret, max, str, end, 3);
 
-		/* If multiplication would cause an overflow. */
-		if (r > mul_max)
-			return PANCL_ERROR_STR_TO_INT_RANGE;
+	case 16:
+		return parse_pow2(ret, max, str, end, 4);
 
-		/* If addition would cause an overflow. */
-		if (r == mul_max && (uintmax_t)v > add_max)
-			return PANCL_ERROR_STR_TO_INT_RANGE;
+	case 32:
+		return parse_pow2(ret, max, str, end, 5);
 
-		r = (r * (uintmax_t)base) + (uintmax_t)v;
+	default:
+		return parse_any(ret, max, str, end, base);
 	}
-
-	*ret = r;
-	return PANCL_SUCCESS;
 }
 
-static int
-str_to_intmax(intmax_t *ret, const char *str, int base,
-	intmax_t min, intmax_t max)
+/**
+ * Signed conversion, @p neg_max is the magnitude of the minimum.
+ */
+static inline int
+str_to_int_internal(int_least64_t *ret, uint64_t neg_max, uint64_t max,
+	const char *str, int base)
 {
 	int err;
-	uintmax_t r;
-	uintmax_t effective_max;
+	uint64_t r;
 	bool negative = false;
 
 	if (str[0] == '-') {
@@ -126,122 +371,67 @@ str_to_intmax(intmax_t *ret, const char *str, int base,
 		++str;
 	}
 
-	effective_max = (uintmax_t)(negative ? -min : max);
-	err = str_to_uintmax_internal(&r, effective_max, str, base);
+	err = str_to_uint_internal(&r, negative ? neg_max : max, str, base);
 
 	if (err == PANCL_SUCCESS) {
+		/* Negating INT64_MIN's magnitude as a signed value overflows. */
 		if (negative)
-			*ret = -(intmax_t)r;
+			*ret = (r == 0) ? 0 : -(int_least64_t)(r - 1) - 1;
 		else
-			*ret = (intmax_t)r;
+			*ret = (int_least64_t)r;
 	}
 
 	return err;
 }
 
-static int
-str_to_uintmax(uintmax_t *ret, const char *str, int base, uintmax_t max)
-{
-	if (str[0] == '+')
-		++str;
-
-	return str_to_uintmax_internal(ret, max, str, base);
-}
-
-int
-str_to_int64(int_least64_t *ret, const char *str, int base)
-{
-	intmax_t r;
-	int err = str_to_intmax(&r, str, base, INT64_MIN, UINT64_MAX);
-
-	if (err == PANCL_SUCCESS)
-		*ret = (int_least64_t)r;
-
-	return err;
-}
-
-int
-str_to_uint64(uint_least64_t *ret, const char *str, int base)
-{
-	uintmax_t r;
-	int err = str_to_uintmax(&r, str, base, UINT64_MAX);
-
-	if (err == PANCL_SUCCESS)
-		*ret = (uint_least64_t)r;
-
-	return err;
-}
-
-int
-str_to_int32(int_least32_t *ret, const char *str, int base)
-{
-	intmax_t r;
-	int err = str_to_intmax(&r, str, base, INT32_MIN, UINT32_MAX);
-
-	if (err == PANCL_SUCCESS)
-		*ret = (int_least32_t)r;
-
-	return err;
-}
-
-int
-str_to_uint32(uint_least32_t *ret, const char *str, int base)
-{
-	uintmax_t r;
-	int err = str_to_uintmax(&r, str, base, UINT32_MAX);
-
-	if (err == PANCL_SUCCESS)
-		*ret = (uint_least32_t)r;
-
-	return err;
-}
-
-int
-str_to_int16(int_least16_t *ret, const char *str, int base)
-{
-	intmax_t r;
-	int err = str_to_intmax(&r, str, base, INT16_MIN, UINT16_MAX);
-
-	if (err == PANCL_SUCCESS)
-		*ret = (int_least16_t)r;
-
-	return err;
-}
-
-int
-str_to_uint16(uint_least16_t *ret, const char *str, int base)
-{
-	uintmax_t r;
-	int err = str_to_uintmax(&r, str, base, UINT16_MAX);
-
-	if (err == PANCL_SUCCESS)
-		*ret = (uint_least16_t)r;
-
-	return err;
-}
+/* Signed types accept values up to the unsigned maximum as well, which wrap
+ * around (bit patterns like 0xffffffff).
+ */
+#define DEFINE_STR_TO_INT(name, type, min, umax) \
+	int \
+	name(type *ret, const char *str, int base) \
+	{ \
+		int_least64_t r; \
+		int err = str_to_int_internal(&r, (uint64_t)0 - (uint64_t)(min), \
+				(umax), str, base); \
+	\
+		if (err == PANCL_SUCCESS) \
+			*ret = (type)r; \
+	\
+		return err; \
+	}
 
-int
-str_to_int8(int_least8_t *ret, const char *str, int base)
-{
-	intmax_t r;
-	int err = str_to_intmax(&r, str, base, INT8_MIN, UINT8_MAX);
+#define DEFINE_STR_TO_UINT(name, type, umax) \
+	int \
+	name(type *ret, const char *str, int base) \
+	{ \
+		uint64_t r; \
+		int err; \
+	\
+		if (str[0] == '+') \
+			++str; \
+	\
+		err = str_to_uint_internal(&r, (umax), str, base); \
+	\
+		if (err == PANCL_SUCCESS) \
+			*ret = (type)r; \
+	\
+		return err; \
+	}
 
-	if (err == PANCL_SUCCESS)
-		*ret = (int_least8_t)r;
+DEFINE_STR_TO_INT(str_to_int64, int_least64_t, INT64_MIN, UINT64_MAX)
+DEFINE_STR_TO_UINT(str_to_uint64, uint_least64_t, UINT64_MAX)
 
-	return err;
-}
+DEFINE_STR_TO_INT(str_to_int32, int_least32_t, INT32_MIN, UINT32_MAX)
+DEFINE_STR_TO_UINT(str_to_uint32, uint_least32_t, UINT32_MAX)
 
-int
-str_to_uint8(uint_least8_t *ret, const char *str, int base)
-{
-	uintmax_t r;
-	int err = str_to_uintmax(&r, str, base, UINT8_MAX);
+DEFINE_STR_TO_INT(str_to_int16, int_least16_t, INT16_MIN, UINT16_MAX)
+DEFINE_STR_TO_UINT(str_to_uint16, uint_least16_t, UINT16_MAX)
 
-	if (err == PANCL_SUCCESS)
-		*ret = (uint_least8_t)r;
+DEFINE_STR_TO_INT(str_to_int8, int_least8_t, INT8_MIN, UINT8_MAX)
+DEFINE_STR_TO_UINT(str_to_uint8, uint_least8_t, UINT8_MAX)
 
-	return err;
-}
+#undef DEFINE_STR_TO_INT
+#undef DEFINE_STR_TO_UINT
 
 // vim:ts=4:sw=4:autoindent
@@ -0,0 +1,595 @@
+/* SPDX-License-Identifier: MIT */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "internal.h"
+
+/**
+ * @file pool.c
+ * @brief Memory pool used for parse tree nodes.
+ *
+ * A pool remembers the allocator of the pancl_context that created it so the
+ * tables referencing it can be freed after the context is gone.
+ *
+ * When the context is in arena mode (PANCL_PARSE_ARENA) every node of a
+ * table is carved out of large chunks owned by the pool.  Individual nodes
+ * are never freed; the chunks are released (or recycled) as a whole once
+ * nothing references the pool anymore.
+ *
+ * In recycling mode (PANCL_PARSE_RECYCLE) small blocks (values, entries,
+ * most strings and containers) are slab allocated instead: they are carved
+ * out of the same chunks, rounded up to a size class, and go onto a
+ * per-class free list when released.  Tables freed by pancl_table_fini()
+ * thus feed the next pancl_get_next_table(), and streaming a document table
+ * by table stops calling the allocator once the largest table has been
+ * seen.  Larger blocks go straight to the allocator.
+ *
+ * Pools can also intern strings (PANCL_PARSE_INTERN_*): every distinct
+ * string is stored once, owned by the pool, and shared by all its users.
+ *
+ * None of this is locked: the context and all of the tables referencing a
+ * pool have to use it from one thread at a time (see struct pancl_context).
+ * A pool doing none of the above is plain: every block goes straight to the
+ * allocator, and blocks from plain pools with the same allocator are
+ * interchangeable, so tables don't need to share the context's pool.
+ */
+
+/**
+ * Size of the first chunk allocated for a pool (including the header).
+ */
+#define POOL_CHUNK_MIN  (4096)
+/**
+ * Chunks double in size until they hit this size.
+ */
+#define POOL_CHUNK_MAX  (1024 * 1024)
+
+/**
+ * Alignment every pool allocation is rounded up to.
+ */
+union pool_align {
+	long double ld;
+	long long ll;
+	void *p;
+	void (*fn)(void);
+};
+
+#define POOL_ALIGN  (sizeof(union pool_align))
+
+/**
+ * Largest block served from the slab free lists.
+ */
+#define POOL_SLAB_MAX  (512)
+/**
+ * Number of slab size classes, each POOL_ALIGN bytes apart.
+ */
+#define POOL_SLAB_CLASSES  (POOL_SLAB_MAX / POOL_ALIGN)
+
+/**
+ * Initial number of buckets of the intern table (a power of 2).
+ */
+#define POOL_INTERN_BUCKETS  (64)
+
+/**
+ * Header of a chunk of pool memory.  The usable memory directly follows it.
+ */
+struct pancl_pool_chunk {
+	struct pancl_pool_chunk *next; /**< Previously filled chunk */
+	size_t size; /**< Usable bytes following the header */
+	union pool_align align; /**< Forces alignment of the data */
+};
+
+/**
+ * Released slab block, linked into the free list of its size class.
+ */
+struct pancl_pool_free {
+	struct pancl_pool_free *next;
+};
+
+/**
+ * Interned string, chained into its intern table bucket.
+ */
+struct pancl_pool_intern {
+	struct pancl_pool_intern *next; /**< Next string in the bucket */
+	size_t hash; /**< Hash of the string data */
+	struct pancl_utf8_string string; /**< Must be last, data follows */
+};
+
+struct pancl_pool {
+	unsigned long refs; /**< Reference count, not atomic */
+	struct pancl_allocator allocator; /**< Where all memory comes from */
+	bool arena; /**< Bump allocate from chunks */
+	bool recycle; /**< Slab allocate small blocks */
+	unsigned int intern; /**< PANCL_PARSE_INTERN_* kinds being interned */
+	struct pancl_pool_intern **buckets; /**< Intern table */
+	size_t bucket_count; /**< Number of buckets (a power of 2) */
+	size_t interned; /**< Number of interned strings */
+	struct pancl_pool_chunk *chunks; /**< Current chunk (head of the list) */
+	char *cursor; /**< Next free byte in the current chunk */
+	char *end; /**< End of the current chunk */
+	/** Released blocks per size class (recycling mode only) */
+	struct pancl_pool_free *free_lists[POOL_SLAB_CLASSES];
+};
+
+/**
+ * Maps a block size to its slab size class.  @p n must be in the range
+ * [1, POOL_SLAB_MAX].
+ */
+static inline size_t
+slab_class(size_t n)
+{
+	return (n - 1) / POOL_ALIGN;
+}
+
+static inline char *
+chunk_data(struct pancl_pool_chunk *chunk)
+{
+	return (char *)&(chunk->align);
+}
+
+static void
+pool_free_chunks(struct pancl_pool *pool)
+{
+	struct pancl_pool_chunk *chunk = pool->chunks;
+
+	while (chunk != NULL) {
+		struct pancl_pool_chunk *next = chunk->next;
+
+		pancl_allocator_free(&(pool->allocator), chunk,
+			chunk->size + offsetof(struct pancl_pool_chunk, align));
+		chunk = next;
+	}
+
+	pool->chunks = NULL;
+	pool->cursor = NULL;
+	pool->end = NULL;
+	memset(pool->free_lists, 0, sizeof(pool->free_lists));
+}
+
+/**
+ * Adds a new chunk able to hold at least @p n bytes to the pool.
+ */
+static int
+pool_add_chunk(struct pancl_pool *pool, size_t n)
+{
+	int err;
+	size_t size = POOL_CHUNK_MIN;
+	size_t total;
+	struct pancl_pool_chunk *chunk;
+
+	/* Chunks grow geometrically so large documents use few of them. */
+	if (pool->chunks != NULL) {
+		size = pool->chunks->size + offsetof(struct pancl_pool_chunk, align);
+
+		if (size < POOL_CHUNK_MAX)
+			size *= 2;
+	}
+
+	err = safe_add(n, offsetof(struct pancl_pool_chunk, align), &total);
+
+	if (err != PANCL_SUCCESS)
+		return err;
+
+	if (total > size)
+		size = total;
+
+	chunk = pancl_allocator_alloc(&(pool->allocator), size);
+
+	if (chunk == NULL)
+		return PANCL_ERROR_ALLOC;
+
+	chunk->size = size - offsetof(struct pancl_pool_chunk, align);
+	chunk->next = pool->chunks;
+
+	pool->chunks = chunk;
+	pool->cursor = chunk_data(chunk);
+	pool->end = pool->cursor + chunk->size;
+
+	return PANCL_SUCCESS;
+}
+
+/**
+ * Releases all interned strings, leaving an empty intern table.
+ */
+static void
+pool_free_interned(struct pancl_pool *pool)
+{
+	size_t i;
+
+	for (i = 0; i < pool->bucket_count; ++i) {
+		struct pancl_pool_intern *node = pool->buckets[i];
+
+		while (node != NULL) {
+			struct pancl_pool_intern *next = node->next;
+
+			pancl_pool_free(pool, node, offsetof(struct pancl_pool_intern,
+					string.data) + node->string.bytes + 1);
+			node = next;
+		}
+
+		pool->buckets[i] = NULL;
+	}
+
+	pool->interned = 0;
+}
+
+int
+pancl_pool_new(struct pancl_pool **pool,
+	const struct pancl_allocator *allocator, unsigned int flags)
+{
+	if (pool == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	*pool = pancl_allocator_alloc(allocator, sizeof(**pool));
+
+	if (*pool == NULL)
+		return PANCL_ERROR_ALLOC;
+
+	memset(*pool, 0, sizeof(**pool));
+
+	if (allocator != NULL)
+		(*pool)->allocator = *allocator;
+
+	(*pool)->refs = 1;
+	(*pool)->arena = ((flags & PANCL_PARSE_ARENA) != 0);
+	(*pool)->recycle = !(*pool)->arena
+		&& (flags & PANCL_PARSE_RECYCLE) != 0;
+	(*pool)->intern = flags
+		& (PANCL_PARSE_INTERN_KEYS | PANCL_PARSE_INTERN_STRINGS);
+	return PANCL_SUCCESS;
+}
+
+struct pancl_pool *
+pancl_pool_ref(struct pancl_pool *pool)
+{
+	if (pool != NULL)
+		pool->refs += 1;
+
+	return pool;
+}
+
+void
+pancl_pool_unref(struct pancl_pool **pool)
+{
+	if (pool == NULL || *pool == NULL)
+		return;
+
+	if (--((*pool)->refs) == 0) {
+		/* Copy the allocator, it lives inside the memory being freed. */
+		struct pancl_allocator allocator = (*pool)->allocator;
+
+		pool_free_interned(*pool);
+		pancl_allocator_free(&allocator, (*pool)->buckets,
+			(*pool)->bucket_count * sizeof(*((*pool)->buckets)));
+		pool_free_chunks(*pool);
+		pancl_allocator_free(&allocator, *pool, sizeof(**pool));
+	}
+
+	*pool = NULL;
+}
+
+bool
+pancl_pool_is_shared(const struct pancl_pool *pool)
+{
+	return (pool != NULL && pool->refs > 1);
+}
+
+bool
+pancl_pool_is_arena(const struct pancl_pool *pool)
+{
+	return (pool != NULL && pool->arena);
+}
+
+bool
+pancl_pool_is_plain(const struct pancl_pool *pool)
+{
+	return (pool == NULL
+		|| (!pool->arena && !pool->recycle && pool->intern == 0));
+}
+
+bool
+pancl_pool_interns(const struct pancl_pool *pool, unsigned int kind)
+{
+	return (pool != NULL && (pool->intern & kind) != 0);
+}
+
+void
+pancl_pool_reset(struct pancl_pool *pool)
+{
+	size_t total = 0;
+	struct pancl_pool_chunk *chunk;
+
+	if (pool == NULL)
+		return;
+
+	/* The interned strings are about to be handed out again. */
+	pool_free_interned(pool);
+
+	if (pool->chunks == NULL)
+		return;
+
+	/* Single chunk: just rewind it. */
+	if (pool->chunks->next == NULL) {
+		pool->cursor = chunk_data(pool->chunks);
+		return;
+	}
+
+	/* Multiple chunks: replace them with one chunk big enough to hold
+	 * everything so the next round needs no allocations at all.  If that
+	 * fails we just start over from scratch.
+	 */
+	for (chunk = pool->chunks; chunk != NULL; chunk = chunk->next) {
+		if (safe_add(total, chunk->size, &total) != PANCL_SUCCESS)
+			break;
+	}
+
+	pool_free_chunks(pool);
+	(void)pool_add_chunk(pool, total);
+}
+
+/**
+ * Carves @p n bytes (a multiple of POOL_ALIGN) out of the current chunk.
+ */
+static void *
+pool_bump(struct pancl_pool *pool, size_t n)
+{
+	void *ret;
+
+	if (n > (size_t)(pool->end - pool->cursor)) {
+		if (pool_add_chunk(pool, n) != PANCL_SUCCESS)
+			return NULL;
+	}
+
+	ret = pool->cursor;
+	pool->cursor += n;
+
+	return ret;
+}
+
+void *
+pancl_pool_alloc(struct pancl_pool *pool, size_t n)
+{
+	if (pool == NULL)
+		return pancl_alloc(n);
+
+	if (n == 0)
+		n = 1;
+
+	if (!pool->arena) {
+		size_t cls;
+		struct pancl_pool_free *block;
+
+		if (!pool->recycle || n > POOL_SLAB_MAX)
+			return pancl_allocator_alloc(&(pool->allocator), n);
+
+		cls = slab_class(n);
+		block = pool->free_lists[cls];
+
+		if (block != NULL) {
+			pool->free_lists[cls] = block->next;
+			return block;
+		}
+
+		return pool_bump(pool, (cls + 1) * POOL_ALIGN);
+	}
+
+	/* Round up so the next allocation stays aligned. */
+	if (n > SIZE_MAX - POOL_ALIGN)
+		return NULL;
+
+	return pool_bump(pool, (n + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1));
+}
+
+void *
+pancl_pool_zalloc(struct pancl_pool *pool, size_t n)
+{
+	void *ret = pancl_pool_alloc(pool, n);
+
+	if (ret != NULL)
+		memset(ret, 0, n);
+
+	return ret;
+}
+
+void
+pancl_pool_free(struct pancl_pool *pool, void *p, size_t size)
+{
+	struct pancl_pool_free *block = p;
+	size_t cls;
+
+	if (pool == NULL) {
+		pancl_free(p);
+		return;
+	}
+
+	/* Arena memory is only ever released as a whole. */
+	if (pool->arena || p == NULL)
+		return;
+
+	if (!pool->recycle || size > POOL_SLAB_MAX) {
+		pancl_allocator_free(&(pool->allocator), p, size);
+		return;
+	}
+
+	cls = slab_class(size == 0 ? 1 : size);
+	block->next = pool->free_lists[cls];
+	pool->free_lists[cls] = block;
+}
+
+int
+pancl_pool_resize(struct pancl_pool *pool, void **p, size_t n,
+	size_t old_count, size_t count)
+{
+	int err;
+	size_t size;
+	size_t old_size;
+	void *d;
+
+	if (pool == NULL)
+		return pancl_resize(NULL, p, n, old_count, count);
+
+	err = safe_mul(n, count, &size);
+
+	if (err != PANCL_SUCCESS)
+		return err;
+
+	/* The old size can't overflow, it was allocated with it. */
+	old_size = n * old_count;
+
+	if (pool->arena) {
+		/* Arena memory can't be resized in place nor given back, so
+		 * shrinking is a no-op and growing copies into a fresh block
+		 * (abandoning the old one until the pool is recycled).
+		 */
+		if (count <= old_count)
+			return PANCL_SUCCESS;
+	}
+	else if (!pool->recycle
+			|| (old_size > POOL_SLAB_MAX && size > POOL_SLAB_MAX)) {
+		/* Both outside the slabs: let the allocator do it. */
+		return pancl_resize(&(pool->allocator), p, n, old_count, count);
+	}
+	else if (old_size != 0 && size <= POOL_SLAB_MAX
+			&& slab_class(old_size) == slab_class(size)) {
+		/* Both within the same size class: nothing to do. */
+		return PANCL_SUCCESS;
+	}
+
+	d = pancl_pool_alloc(pool, size);
+
+	if (d == NULL)
+		return PANCL_ERROR_ALLOC;
+
+	if (old_count != 0) {
+		memcpy(d, *p, (old_size < size) ? old_size : size);
+		pancl_pool_free(pool, *p, old_size);
+	}
+
+	*p = d;
+	return PANCL_SUCCESS;
+}
+
+/**
+ * FNV-1a over the string data.
+ */
+static size_t
+intern_hash(const char *data, size_t bytes)
+{
+	uint_least64_t h = UINT64_C(14695981039346656037);
+	size_t i;
+
+	for (i = 0; i < bytes; ++i) {
+		h ^= (unsigned char)data[i];
+		h *= UINT64_C(1099511628211);
+	}
+
+	return (size_t)h;
+}
+
+/**
+ * Doubles the number of intern table buckets (or creates the table).
+ */
+static int
+intern_grow(struct pancl_pool *pool)
+{
+	size_t count = POOL_INTERN_BUCKETS;
+	size_t size;
+	size_t i;
+	struct pancl_pool_intern **buckets;
+
+	if (pool->bucket_count != 0 && !can_inc(pool->bucket_count))
+		return PANCL_ERROR_OVERFLOW;
+
+	if (pool->bucket_count != 0)
+		count = pool->bucket_count * 2;
+
+	if (safe_mul(count, sizeof(*buckets), &size) != PANCL_SUCCESS)
+		return PANCL_ERROR_OVERFLOW;
+
+	buckets = pancl_allocator_alloc(&(pool->allocator), size);
+
+	if (buckets == NULL)
+		return PANCL_ERROR_ALLOC;
+
+	memset(buckets, 0, size);
+
+	for (i = 0; i < pool->bucket_count; ++i) {
+		struct pancl_pool_intern *node = pool->buckets[i];
+
+		while (node != NULL) {
+			struct pancl_pool_intern *next = node->next;
+			size_t b = node->hash & (count - 1);
+
+			node->next = buckets[b];
+			buckets[b] = node;
+			node = next;
+		}
+	}
+
+	pancl_allocator_free(&(pool->allocator), pool->buckets,
+		pool->bucket_count * sizeof(*buckets));
+
+	pool->buckets = buckets;
+	pool->bucket_count = count;
+
+	return PANCL_SUCCESS;
+}
+
+int
+pancl_pool_intern(struct pancl_pool *pool, const char *data, size_t bytes,
+	size_t codepoints, struct pancl_utf8_string **string)
+{
+	int err;
+	size_t hash;
+	size_t size;
+	struct pancl_pool_intern *node;
+
+	hash = intern_hash(data, bytes);
+
+	for (node = (pool->bucket_count == 0) ? NULL
+			: pool->buckets[hash & (pool->bucket_count - 1)];
+			node != NULL; node = node->next) {
+		if (node->hash == hash && node->string.bytes == bytes
+				&& memcmp(node->string.data, data, bytes) == 0) {
+			*string = &(node->string);
+			return PANCL_SUCCESS;
+		}
+	}
+
+	/* Keep the load factor at or below 1. */
+	if (pool->interned >= pool->bucket_count) {
+		err = intern_grow(pool);
+
+		if (err != PANCL_SUCCESS)
+			return err;
+	}
+
+	err = safe_add(offsetof(struct pancl_pool_intern, string.data) + 1,
+			bytes, &size);
+
+	if (err != PANCL_SUCCESS)
+		return err;
+
+	node = pancl_pool_alloc(pool, size);
+
+	if (node == NULL)
+		return PANCL_ERROR_ALLOC;
+
+	node->hash = hash;
+	node->string.bytes = bytes;
+	node->string.codepoints = codepoints;
+	memcpy(node->string.data, data, bytes);
+	node->string.data[bytes] = '\0';
+
+	node->next = pool->buckets[hash & (pool->bucket_count - 1)];
+	pool->buckets[hash & (pool->bucket_count - 1)] = node;
+	pool->interned += 1;
+
+	*string = &(node->string);
+	return PANCL_SUCCESS;
+}
+
+// vim:ts=4:sw=4:autoindent
@@ -14,7 +14,7 @@ pancl_array_init(struct pancl_array *array)
 }
 
 void
-pancl_array_fini(struct pancl_array *array)
+pancl_array_fini(struct pancl_pool *pool, struct pancl_array *array)
 {
 	if (array == NULL)
 		return;
@@ -22,17 +22,77 @@ pancl_array_fini(struct pancl_array *array)
 	if (array->values != NULL) {
 		size_t i;
 
-		for (i = 0; i < array->count; ++i)
-			pancl_value_destroy(&(array->values[i]));
+		for (i = 0; i < array->count; ++i) {
+#if defined(PANCL_INLINE_CONTAINERS)
+			pancl_value_fini(pool, &(array->values[i]));
+#else
+			pancl_value_release(pool, &(array->values[i]));
+#endif
+		}
 
-		pancl_free(array->values);
+		pancl_pool_free(pool, array->values,
+			array->capacity * sizeof(*(array->values)));
 	}
 
 	pancl_array_init(array);
 }
 
 int
-pancl_array_append(struct pancl_array *array, struct pancl_value *value)
+pancl_array_reserve(struct pancl_pool *pool, struct pancl_array *array,
+	size_t capacity)
+{
+	int err;
+
+	if (array == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	if (capacity <= array->capacity)
+		return PANCL_SUCCESS;
+
+	err = pancl_pool_resize(pool, (void **)&(array->values),
+			sizeof(*(array->values)), array->capacity, capacity);
+
+	if (err == PANCL_SUCCESS)
+		array->capacity = capacity;
+
+	return err;
+}
+
+int
+pancl_array_shrink_to_fit(struct pancl_pool *pool, struct pancl_array *array)
+{
+	int err = PANCL_SUCCESS;
+	size_t i;
+
+	if (array == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	for (i = 0; i < array->count && err == PANCL_SUCCESS; ++i)
+		err = pancl_value_shrink_to_fit(pool, pancl_array_at(array, i));
+
+	if (err != PANCL_SUCCESS || array->capacity == array->count)
+		return err;
+
+	if (array->count == 0) {
+		pancl_pool_free(pool, array->values,
+			array->capacity * sizeof(*(array->values)));
+		array->values = NULL;
+		array->capacity = 0;
+		return PANCL_SUCCESS;
+	}
+
+	err = pancl_pool_resize(pool, (void **)&(array->values),
+			sizeof(*(array->values)), array->capacity, array->count);
+
+	if (err == PANCL_SUCCESS)
+		array->capacity = array->count;
+
+	return err;
+}
+
+int
+pancl_array_append(struct pancl_pool *pool, struct pancl_array *array,
+	struct pancl_value *value)
 {
 	int err;
 
@@ -41,22 +101,31 @@ pancl_array_append(struct pancl_array *array, struct pancl_value *value)
 
 	/* Arrays have to validate that they only hold one type of data. */
 	if (array->count != 0) {
-		if (array->values[0]->type != value->type)
+		if (pancl_array_at(array, 0)->type != value->type)
 			return PANCL_ERROR_ARRAY_MEMBER_TYPE;
 	}
 
 	if (!can_inc(array->count))
 		return PANCL_ERROR_OVERFLOW;
 
-	err = pancl_resize((void **)&(array->values), sizeof(*(array->values)),
-			array->count + 1);
+	if (array->count == array->capacity) {
+		err = pancl_array_reserve(pool, array,
+				grow_capacity(array->capacity));
 
-	if (err == PANCL_SUCCESS) {
-		array->values[array->count] = value;
-		array->count += 1;
+		if (err != PANCL_SUCCESS)
+			return err;
 	}
 
-	return err;
+#if defined(PANCL_INLINE_CONTAINERS)
+	/* The value is moved into place, leaving only its node to be freed. */
+	array->values[array->count] = *value;
+	pancl_pool_free(pool, value, sizeof(*value));
+#else
+	array->values[array->count] = value;
+#endif
+	array->count += 1;
+
+	return PANCL_SUCCESS;
 }
 
 // vim:ts=4:sw=4:autoindent
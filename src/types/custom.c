@@ -18,13 +18,13 @@ pancl_custom_init(struct pancl_custom *custom)
 }
 
 void
-pancl_custom_fini(struct pancl_custom *custom)
+pancl_custom_fini(struct pancl_pool *pool, struct pancl_custom *custom)
 {
 	if (custom == NULL)
 		return;
 
-	pancl_utf8_string_destroy(&(custom->name));
-	pancl_tuple_fini(&(custom->tuple));
+	pancl_string_release(pool, STRING_KEY, &(custom->name));
+	pancl_tuple_fini(pool, &(custom->tuple));
 
 	pancl_custom_init(custom);
 }
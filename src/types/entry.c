@@ -17,12 +17,12 @@ pancl_entry_init(struct pancl_entry *entry)
 }
 
 int
-pancl_entry_new(struct pancl_entry **entry)
+pancl_entry_new(struct pancl_pool *pool, struct pancl_entry **entry)
 {
 	if (entry == NULL)
 		return PANCL_ERROR_ARG_INVALID;
 
-	*entry = pancl_alloc(sizeof(**entry));
+	*entry = pancl_pool_alloc(pool, sizeof(**entry));
 
 	if (*entry == NULL)
 		return PANCL_ERROR_ALLOC;
@@ -32,26 +32,32 @@ pancl_entry_new(struct pancl_entry **entry)
 }
 
 void
-pancl_entry_fini(struct pancl_entry *entry)
+pancl_entry_fini(struct pancl_pool *pool, struct pancl_entry *entry)
 {
 	if (entry == NULL)
 		return;
 
-	pancl_utf8_string_destroy(&(entry->name));
-	pancl_value_fini(&(entry->value));
+	pancl_string_release(pool, STRING_KEY, &(entry->name));
+	pancl_value_fini(pool, &(entry->value));
 
 	pancl_entry_init(entry);
 }
 
 void
-pancl_entry_destroy(struct pancl_entry **entry)
+pancl_entry_release(struct pancl_pool *pool, struct pancl_entry **entry)
 {
 	if (entry == NULL || *entry == NULL)
 		return;
 
-	pancl_entry_fini(*entry);
-	pancl_free(*entry);
+	pancl_entry_fini(pool, *entry);
+	pancl_pool_free(pool, *entry, sizeof(**entry));
 	*entry = NULL;
 }
 
+void
+pancl_entry_destroy(struct pancl_entry **entry)
+{
+	pancl_entry_release(NULL, entry);
+}
+
 // vim:ts=4:sw=4:autoindent
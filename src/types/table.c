@@ -21,10 +21,31 @@ pancl_table_fini(struct pancl_table *table)
 	if (table == NULL)
 		return;
 
-	pancl_utf8_string_destroy(&(table->name));
-	pancl_table_data_fini(&(table->data));
+	/* Arena-backed tables are released all at once when the pool goes away
+	 * (or gets recycled), so there's no need to walk the nodes.
+	 */
+	if (!pancl_pool_is_arena(table->pool)) {
+		pancl_string_release(table->pool, STRING_KEY,
+			&(table->name));
+		pancl_table_data_fini(table->pool, &(table->data));
+	}
+
+	pancl_pool_unref(&(table->pool));
 
 	pancl_table_init(table);
 }
 
+int
+pancl_table_shrink_to_fit(struct pancl_table *table)
+{
+	if (table == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	/* Nothing to give back to an arena. */
+	if (pancl_pool_is_arena(table->pool))
+		return PANCL_SUCCESS;
+
+	return pancl_table_data_shrink_to_fit(table->pool, &(table->data));
+}
+
 // vim:ts=4:sw=4:autoindent
@@ -14,7 +14,7 @@ pancl_table_data_init(struct pancl_table_data *td)
 }
 
 void
-pancl_table_data_fini(struct pancl_table_data *td)
+pancl_table_data_fini(struct pancl_pool *pool, struct pancl_table_data *td)
 {
 	if (td == NULL)
 		return;
@@ -22,17 +22,79 @@ pancl_table_data_fini(struct pancl_table_data *td)
 	if (td->entries != NULL) {
 		size_t i;
 
-		for (i = 0; i < td->count; ++i)
-			pancl_entry_destroy(&(td->entries[i]));
+		for (i = 0; i < td->count; ++i) {
+#if defined(PANCL_INLINE_CONTAINERS)
+			pancl_entry_fini(pool, &(td->entries[i]));
+#else
+			pancl_entry_release(pool, &(td->entries[i]));
+#endif
+		}
 
-		pancl_free(td->entries);
+		pancl_pool_free(pool, td->entries,
+			td->capacity * sizeof(*(td->entries)));
 	}
 
 	pancl_table_data_init(td);
 }
 
 int
-pancl_table_data_append(struct pancl_table_data *td, struct pancl_entry *entry)
+pancl_table_data_reserve(struct pancl_pool *pool, struct pancl_table_data *td,
+	size_t capacity)
+{
+	int err;
+
+	if (td == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	if (capacity <= td->capacity)
+		return PANCL_SUCCESS;
+
+	err = pancl_pool_resize(pool, (void **)&(td->entries),
+			sizeof(*(td->entries)), td->capacity, capacity);
+
+	if (err == PANCL_SUCCESS)
+		td->capacity = capacity;
+
+	return err;
+}
+
+int
+pancl_table_data_shrink_to_fit(struct pancl_pool *pool,
+	struct pancl_table_data *td)
+{
+	int err = PANCL_SUCCESS;
+	size_t i;
+
+	if (td == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	for (i = 0; i < td->count && err == PANCL_SUCCESS; ++i)
+		err = pancl_value_shrink_to_fit(pool,
+				&(pancl_table_data_at(td, i)->value));
+
+	if (err != PANCL_SUCCESS || td->capacity == td->count)
+		return err;
+
+	if (td->count == 0) {
+		pancl_pool_free(pool, td->entries,
+			td->capacity * sizeof(*(td->entries)));
+		td->entries = NULL;
+		td->capacity = 0;
+		return PANCL_SUCCESS;
+	}
+
+	err = pancl_pool_resize(pool, (void **)&(td->entries),
+			sizeof(*(td->entries)), td->capacity, td->count);
+
+	if (err == PANCL_SUCCESS)
+		td->capacity = td->count;
+
+	return err;
+}
+
+int
+pancl_table_data_append(struct pancl_pool *pool, struct pancl_table_data *td,
+	struct pancl_entry *entry)
 {
 	int err;
 
@@ -42,15 +104,23 @@ pancl_table_data_append(struct pancl_table_data *td, struct pancl_entry *entry)
 	if (!can_inc(td->count))
 		return PANCL_ERROR_OVERFLOW;
 
-	err = pancl_resize((void **)&(td->entries), sizeof(*(td->entries)),
-			td->count + 1);
+	if (td->count == td->capacity) {
+		err = pancl_table_data_reserve(pool, td, grow_capacity(td->capacity));
 
-	if (err == PANCL_SUCCESS) {
-		td->entries[td->count] = entry;
-		td->count += 1;
+		if (err != PANCL_SUCCESS)
+			return err;
 	}
 
-	return err;
+#if defined(PANCL_INLINE_CONTAINERS)
+	/* The entry is moved into place, leaving only its node to be freed. */
+	td->entries[td->count] = *entry;
+	pancl_pool_free(pool, entry, sizeof(*entry));
+#else
+	td->entries[td->count] = entry;
+#endif
+	td->count += 1;
+
+	return PANCL_SUCCESS;
 }
 
 // vim:ts=4:sw=4:autoindent
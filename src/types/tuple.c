@@ -14,7 +14,7 @@ pancl_tuple_init(struct pancl_tuple *tuple)
 }
 
 void
-pancl_tuple_fini(struct pancl_tuple *tuple)
+pancl_tuple_fini(struct pancl_pool *pool, struct pancl_tuple *tuple)
 {
 	if (tuple == NULL)
 		return;
@@ -22,17 +22,77 @@ pancl_tuple_fini(struct pancl_tuple *tuple)
 	if (tuple->values != NULL) {
 		size_t i;
 
-		for (i = 0; i < tuple->count; ++i)
-			pancl_value_destroy(&(tuple->values[i]));
+		for (i = 0; i < tuple->count; ++i) {
+#if defined(PANCL_INLINE_CONTAINERS)
+			pancl_value_fini(pool, &(tuple->values[i]));
+#else
+			pancl_value_release(pool, &(tuple->values[i]));
+#endif
+		}
 
-		pancl_free(tuple->values);
+		pancl_pool_free(pool, tuple->values,
+			tuple->capacity * sizeof(*(tuple->values)));
 	}
 
 	pancl_tuple_init(tuple);
 }
 
 int
-pancl_tuple_append(struct pancl_tuple *tuple, struct pancl_value *value)
+pancl_tuple_reserve(struct pancl_pool *pool, struct pancl_tuple *tuple,
+	size_t capacity)
+{
+	int err;
+
+	if (tuple == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	if (capacity <= tuple->capacity)
+		return PANCL_SUCCESS;
+
+	err = pancl_pool_resize(pool, (void **)&(tuple->values),
+			sizeof(*(tuple->values)), tuple->capacity, capacity);
+
+	if (err == PANCL_SUCCESS)
+		tuple->capacity = capacity;
+
+	return err;
+}
+
+int
+pancl_tuple_shrink_to_fit(struct pancl_pool *pool, struct pancl_tuple *tuple)
+{
+	int err = PANCL_SUCCESS;
+	size_t i;
+
+	if (tuple == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	for (i = 0; i < tuple->count && err == PANCL_SUCCESS; ++i)
+		err = pancl_value_shrink_to_fit(pool, pancl_tuple_at(tuple, i));
+
+	if (err != PANCL_SUCCESS || tuple->capacity == tuple->count)
+		return err;
+
+	if (tuple->count == 0) {
+		pancl_pool_free(pool, tuple->values,
+			tuple->capacity * sizeof(*(tuple->values)));
+		tuple->values = NULL;
+		tuple->capacity = 0;
+		return PANCL_SUCCESS;
+	}
+
+	err = pancl_pool_resize(pool, (void **)&(tuple->values),
+			sizeof(*(tuple->values)), tuple->capacity, tuple->count);
+
+	if (err == PANCL_SUCCESS)
+		tuple->capacity = tuple->count;
+
+	return err;
+}
+
+int
+pancl_tuple_append(struct pancl_pool *pool, struct pancl_tuple *tuple,
+	struct pancl_value *value)
 {
 	int err;
 
@@ -42,15 +102,24 @@ pancl_tuple_append(struct pancl_tuple *tuple, struct pancl_value *value)
 	if (!can_inc(tuple->count))
 		return PANCL_ERROR_OVERFLOW;
 
-	err = pancl_resize((void **)&(tuple->values), sizeof(*(tuple->values)),
-			tuple->count + 1);
+	if (tuple->count == tuple->capacity) {
+		err = pancl_tuple_reserve(pool, tuple,
+				grow_capacity(tuple->capacity));
 
-	if (err == PANCL_SUCCESS) {
-		tuple->values[tuple->count] = value;
-		tuple->count += 1;
+		if (err != PANCL_SUCCESS)
+			return err;
 	}
 
-	return err;
+#if defined(PANCL_INLINE_CONTAINERS)
+	/* The value is moved into place, leaving only its node to be freed. */
+	tuple->values[tuple->count] = *value;
+	pancl_pool_free(pool, value, sizeof(*value));
+#else
+	tuple->values[tuple->count] = value;
+#endif
+	tuple->count += 1;
+
+	return PANCL_SUCCESS;
 }
 
 // vim:ts=4:sw=4:autoindent
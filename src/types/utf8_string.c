@@ -1,5 +1,6 @@
 /* SPDX-License-Identifier: MIT */
 #include <limits.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,8 +9,8 @@
 #include "internal.h"
 
 int
-pancl_utf8_string_new(struct pancl_utf8_string **string,
-	size_t bytes)
+pancl_utf8_string_new(struct pancl_pool *pool,
+	struct pancl_utf8_string **string, size_t bytes)
 {
 	int err;
 	size_t total_size;
@@ -22,7 +23,7 @@ pancl_utf8_string_new(struct pancl_utf8_string **string,
 	if (err != 0)
 		return err;
 
-	*string = pancl_zalloc(total_size);
+	*string = pancl_pool_zalloc(pool, total_size);
 
 	if (*string == NULL)
 		return PANCL_ERROR_ALLOC;
@@ -33,13 +34,143 @@ pancl_utf8_string_new(struct pancl_utf8_string **string,
 }
 
 void
-pancl_utf8_string_destroy(struct pancl_utf8_string **string)
+pancl_utf8_string_release(struct pancl_pool *pool,
+	struct pancl_utf8_string **string)
 {
 	if (string == NULL || *string == NULL)
 		return;
 
-	pancl_free(*string);
+	pancl_pool_free(pool, *string, sizeof(**string) + (*string)->bytes);
 	*string = NULL;
 }
 
+/**
+ * Points a pancl_string at a heap (or interned) string.
+ */
+static void
+string_store(pancl_string *dest, struct pancl_utf8_string *s)
+{
+#if defined(PANCL_SSO_STRINGS)
+	memset(dest, 0, sizeof(*dest));
+
+	if (s == NULL)
+		return;
+
+	memcpy(dest->data, &s, sizeof(s));
+	dest->tag = PANCL_STRING_HEAP;
+#else
+	*dest = s;
+#endif
+}
+
+/**
+ * Moves a (token) string into a pancl_string, which takes ownership.  If the
+ * pool interns strings of @p kind the pancl_string gets the shared copy.
+ */
+int
+pancl_string_take(struct pancl_pool *pool, unsigned int kind,
+	pancl_string *dest, struct pancl_utf8_string **src)
+{
+	struct pancl_utf8_string *s = *src;
+	/* Interned strings stay shared so they can be compared by pointer. */
+	bool copy = pancl_pool_interns(pool, kind);
+
+	if (s == NULL) {
+		string_store(dest, NULL);
+		return PANCL_SUCCESS;
+	}
+
+#if defined(PANCL_SSO_STRINGS)
+	/* Short enough to live inline, the original can go right away. */
+	copy = copy || s->bytes <= PANCL_STRING_INLINE_MAX;
+#endif
+
+	if (copy) {
+		int err = pancl_string_copy(pool, kind, dest, s->data, s->bytes,
+				s->codepoints);
+
+		if (err == PANCL_SUCCESS)
+			pancl_utf8_string_release(pool, src);
+
+		return err;
+	}
+
+	string_store(dest, s);
+	*src = NULL;
+	return PANCL_SUCCESS;
+}
+
+/**
+ * Copies @p bytes bytes of @p data into a pancl_string (with interning if
+ * the pool interns strings of @p kind).
+ */
+int
+pancl_string_copy(struct pancl_pool *pool, unsigned int kind,
+	pancl_string *dest, const char *data, size_t bytes, size_t codepoints)
+{
+	int err;
+	struct pancl_utf8_string *s;
+
+	if (pancl_pool_interns(pool, kind)) {
+		err = pancl_pool_intern(pool, data, bytes, codepoints, &s);
+
+		if (err == PANCL_SUCCESS)
+			string_store(dest, s);
+
+		return err;
+	}
+
+#if defined(PANCL_SSO_STRINGS)
+	if (bytes <= PANCL_STRING_INLINE_MAX) {
+		memset(dest, 0, sizeof(*dest));
+		memcpy(dest->data, data, bytes);
+		dest->tag = (unsigned char)(bytes + 1);
+		dest->codepoints = (unsigned char)codepoints;
+		return PANCL_SUCCESS;
+	}
+#endif
+
+	err = pancl_utf8_string_new(pool, &s, bytes);
+
+	if (err != PANCL_SUCCESS)
+		return err;
+
+	/* pancl_utf8_string_new() zeroes, so the NUL is already there. */
+	memcpy(s->data, data, bytes);
+	s->codepoints = codepoints;
+
+	string_store(dest, s);
+	return PANCL_SUCCESS;
+}
+
+void
+pancl_string_release(struct pancl_pool *pool, unsigned int kind,
+	pancl_string *string)
+{
+	/* Interned strings belong to the pool. */
+	if (pancl_pool_interns(pool, kind)) {
+		memset(string, 0, sizeof(*string));
+		return;
+	}
+
+#if defined(PANCL_SSO_STRINGS)
+	if (string->tag == PANCL_STRING_HEAP) {
+		struct pancl_utf8_string *heap;
+
+		memcpy(&heap, string->data, sizeof(heap));
+		pancl_utf8_string_release(pool, &heap);
+	}
+
+	memset(string, 0, sizeof(*string));
+#else
+	pancl_utf8_string_release(pool, string);
+#endif
+}
+
+void
+pancl_utf8_string_destroy(struct pancl_utf8_string **string)
+{
+	pancl_utf8_string_release(NULL, string);
+}
+
 // vim:ts=4:sw=4:autoindent
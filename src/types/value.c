@@ -6,6 +6,33 @@
 #include "pancl/pancl.h"
 #include "internal.h"
 
+#if defined(PANCL_COMPACT_VALUES)
+/**
+ * Size of the separately allocated data of a @p type value, 0 for types
+ * stored inside the value.
+ */
+static size_t
+value_data_size(enum pancl_type type)
+{
+	switch (type) {
+	case PANCL_TYPE_ARRAY:
+		return sizeof(struct pancl_array);
+	case PANCL_TYPE_CUSTOM:
+		return sizeof(struct pancl_custom);
+	case PANCL_TYPE_TABLE:
+		return sizeof(struct pancl_table_data);
+	case PANCL_TYPE_TUPLE:
+		return sizeof(struct pancl_tuple);
+	default:
+		return 0;
+	}
+}
+#endif
+
+/**
+ * Initializes a value, leaving out-of-line data (see PANCL_COMPACT_VALUES)
+ * unallocated.  Use pancl_value_init_data() for values that are filled in.
+ */
 void
 pancl_value_init(struct pancl_value *value, enum pancl_type type)
 {
@@ -17,11 +44,11 @@ pancl_value_init(struct pancl_value *value, enum pancl_type type)
 
 	switch (type) {
 	case PANCL_TYPE_ARRAY:
-		pancl_array_init(&(value->data.array));
+		pancl_array_init(pancl_value_array(value));
 		break;
 
 	case PANCL_TYPE_CUSTOM:
-		pancl_custom_init(&(value->data.custom));
+		pancl_custom_init(pancl_value_custom(value));
 		break;
 
 	case PANCL_TYPE_BOOLEAN:
@@ -37,15 +64,15 @@ pancl_value_init(struct pancl_value *value, enum pancl_type type)
 		break;
 
 	case PANCL_TYPE_STRING:
-		value->data.string = NULL;
+		memset(&(value->data.string), 0, sizeof(value->data.string));
 		break;
 
 	case PANCL_TYPE_TABLE:
-		pancl_table_data_init(&(value->data.table));
+		pancl_table_data_init(pancl_value_table(value));
 		break;
 
 	case PANCL_TYPE_TUPLE:
-		pancl_tuple_init(&(value->data.tuple));
+		pancl_tuple_init(pancl_value_tuple(value));
 		break;
 
 	case PANCL_TYPE_OPT_INT8:
@@ -82,13 +109,65 @@ pancl_value_init(struct pancl_value *value, enum pancl_type type)
 	}
 }
 
+/**
+ * Initializes a value of @p type along with its data.  With
+ * PANCL_COMPACT_VALUES arrays, custom types, tables and tuples get their
+ * data allocated from @p pool.
+ */
+int
+pancl_value_init_data(struct pancl_pool *pool, struct pancl_value *value,
+	enum pancl_type type)
+{
+#if defined(PANCL_COMPACT_VALUES)
+	void *data;
+	size_t size = value_data_size(type);
+
+	pancl_value_init(value, type);
+
+	if (size == 0)
+		return PANCL_SUCCESS;
+
+	data = pancl_pool_alloc(pool, size);
+
+	if (data == NULL)
+		return PANCL_ERROR_ALLOC;
+
+	switch (type) {
+	case PANCL_TYPE_ARRAY:
+		value->data.array = data;
+		pancl_array_init(value->data.array);
+		break;
+
+	case PANCL_TYPE_CUSTOM:
+		value->data.custom = data;
+		pancl_custom_init(value->data.custom);
+		break;
+
+	case PANCL_TYPE_TABLE:
+		value->data.table = data;
+		pancl_table_data_init(value->data.table);
+		break;
+
+	default:
+		value->data.tuple = data;
+		pancl_tuple_init(value->data.tuple);
+		break;
+	}
+#else
+	(void)pool;
+	pancl_value_init(value, type);
+#endif
+	return PANCL_SUCCESS;
+}
+
 int
-pancl_value_new(struct pancl_value **value, enum pancl_type type)
+pancl_value_new(struct pancl_pool *pool, struct pancl_value **value,
+	enum pancl_type type)
 {
 	if (value == NULL)
 		return PANCL_ERROR_ARG_INVALID;
 
-	*value = pancl_alloc(sizeof(**value));
+	*value = pancl_pool_alloc(pool, sizeof(**value));
 
 	if (*value == NULL)
 		return PANCL_ERROR_ALLOC;
@@ -97,19 +176,27 @@ pancl_value_new(struct pancl_value **value, enum pancl_type type)
 	return PANCL_SUCCESS;
 }
 
+/**
+ * Releases whatever a value holds without resetting the value itself, so
+ * the caller can store other data in it.
+ */
 void
-pancl_value_fini(struct pancl_value *value)
+pancl_value_fini_data(struct pancl_pool *pool, struct pancl_value *value)
 {
+	void *data = NULL;
+
 	if (value == NULL)
 		return;
 
 	switch (value->type) {
 	case PANCL_TYPE_ARRAY:
-		pancl_array_fini(&(value->data.array));
+		data = pancl_value_array(value);
+		pancl_array_fini(pool, data);
 		break;
 
 	case PANCL_TYPE_CUSTOM:
-		pancl_custom_fini(&(value->data.custom));
+		data = pancl_value_custom(value);
+		pancl_custom_fini(pool, data);
 		break;
 
 	case PANCL_TYPE_BOOLEAN:
@@ -126,30 +213,79 @@ pancl_value_fini(struct pancl_value *value)
 		break;
 
 	case PANCL_TYPE_STRING:
-		pancl_utf8_string_destroy(&(value->data.string));
+		pancl_string_release(pool, STRING_VALUE, &(value->data.string));
 		break;
 
 	case PANCL_TYPE_TABLE:
-		pancl_table_data_fini(&(value->data.table));
+		data = pancl_value_table(value);
+		pancl_table_data_fini(pool, data);
 		break;
 
 	case PANCL_TYPE_TUPLE:
-		pancl_tuple_fini(&(value->data.tuple));
+		data = pancl_value_tuple(value);
+		pancl_tuple_fini(pool, data);
 		break;
 	}
 
+#if defined(PANCL_COMPACT_VALUES)
+	if (data != NULL)
+		pancl_pool_free(pool, data, value_data_size(value->type));
+#else
+	(void)data;
+#endif
+}
+
+void
+pancl_value_fini(struct pancl_pool *pool, struct pancl_value *value)
+{
+	if (value == NULL)
+		return;
+
+	pancl_value_fini_data(pool, value);
 	pancl_value_init(value, value->type);
 }
 
 void
-pancl_value_destroy(struct pancl_value **value)
+pancl_value_release(struct pancl_pool *pool, struct pancl_value **value)
 {
 	if (value == NULL || *value == NULL)
 		return;
 
-	pancl_value_fini(*value);
-	pancl_free(*value);
+	pancl_value_fini(pool, *value);
+	pancl_pool_free(pool, *value, sizeof(**value));
 	*value = NULL;
 }
 
+int
+pancl_value_shrink_to_fit(struct pancl_pool *pool, struct pancl_value *value)
+{
+	if (value == NULL)
+		return PANCL_ERROR_ARG_INVALID;
+
+	switch (value->type) {
+	case PANCL_TYPE_ARRAY:
+		return pancl_array_shrink_to_fit(pool, pancl_value_array(value));
+
+	case PANCL_TYPE_CUSTOM:
+		return pancl_tuple_shrink_to_fit(pool,
+				&(pancl_value_custom(value)->tuple));
+
+	case PANCL_TYPE_TABLE:
+		return pancl_table_data_shrink_to_fit(pool, pancl_value_table(value));
+
+	case PANCL_TYPE_TUPLE:
+		return pancl_tuple_shrink_to_fit(pool, pancl_value_tuple(value));
+
+	default:
+		/* Scalars have nothing to trim. */
+		return PANCL_SUCCESS;
+	}
+}
+
+void
+pancl_value_destroy(struct pancl_value **value)
+{
+	pancl_value_release(NULL, value);
+}
+
 // vim:ts=4:sw=4:autoindent
@@ -0,0 +1,464 @@
+/* SPDX-License-Identifier: MIT */
+/* fileno() */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file common.c
+ * @brief Helpers shared by the test programs.
+ */
+
+
+/**
+ * Number of failed checks so far.
+ */
+static int failures;
+
+
+/**
+ * Records a failed check.
+ *
+ * @param[in] ok     Whether the check passed
+ * @param[in] what   Text of the check
+ * @param[in] file   File the check is in
+ * @param[in] line   Line the check is on
+ */
+void
+test_check(bool ok, const char *what, const char *file, int line)
+{
+	if (ok)
+		return;
+
+	fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+	++failures;
+}
+
+/**
+ * Reports the result of a test program.
+ *
+ * @param[in] name   Name of the test program
+ *
+ * @return Returns the exit status for main().
+ */
+int
+test_finish(const char *name)
+{
+	if (failures != 0) {
+		fprintf(stderr, "%s: %d check(s) failed\n", name, failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("%s: ok\n", name);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Creates a temporary file holding @p input.
+ *
+ * @param[in] input   Content of the file
+ * @param[in] size    Length of @p input in bytes
+ *
+ * @return Returns the file, positioned at its start.  Exits on failure.
+ */
+FILE *
+test_file(const char *input, size_t size)
+{
+	FILE *f = tmpfile();
+
+	if (f == NULL || fwrite(input, 1, size, f) != size
+			|| fflush(f) != 0) {
+		perror("tmpfile");
+		exit(EXIT_FAILURE);
+	}
+
+	rewind(f);
+	return f;
+}
+
+
+/**
+ * Parses @p input from memory and checks that its first entry is the string
+ * @p value.
+ *
+ * @param[in] input   Input to parse
+ * @param[in] size    Length of @p input in bytes
+ * @param[in] value   Expected string
+ * @param[in] bytes   Length of @p value in bytes
+ *
+ * @return Returns true if the entry has the expected value.
+ */
+bool
+test_string_value(const char *input, size_t size, const char *value,
+	size_t bytes)
+{
+	bool ok = false;
+	const pancl_string *string;
+	struct pancl_context ctx;
+	struct pancl_table table;
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+
+	if (pancl_parse_buffer(&ctx, input, size) == PANCL_SUCCESS
+			&& pancl_get_next_table(&ctx, &table) == PANCL_SUCCESS
+			&& table.data.count != 0) {
+		const struct pancl_entry *entry =
+			pancl_table_data_at(&(table.data), 0);
+
+		string = &(entry->value.data.string);
+		ok = entry->value.type == PANCL_TYPE_STRING
+			&& pancl_string_bytes(string) == bytes
+			&& memcmp(pancl_string_data(string), value, bytes) == 0;
+	}
+
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+	return ok;
+}
+
+
+/**
+ * Initializes an empty dump.
+ */
+void
+test_dump_init(struct test_dump *dump)
+{
+	memset(dump, 0, sizeof(*dump));
+}
+
+/**
+ * Releases the text of a dump.
+ */
+void
+test_dump_fini(struct test_dump *dump)
+{
+	free(dump->data);
+	test_dump_init(dump);
+}
+
+/**
+ * Checks if two dumps hold the same text.
+ */
+bool
+test_dump_equal(const struct test_dump *a, const struct test_dump *b)
+{
+	/* Empty dumps have no data to memcmp(). */
+	return a->size == b->size
+		&& (a->size == 0 || memcmp(a->data, b->data, a->size) == 0);
+}
+
+/**
+ * Appends printf() formatted text to a dump.
+ */
+static void
+dump_printf(struct test_dump *dump, const char *format, ...)
+{
+	int n;
+	va_list args;
+
+	va_start(args, format);
+	n = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if (n < 0)
+		abort();
+
+	if (dump->size + (size_t)n + 1 > dump->capacity) {
+		size_t capacity = (dump->capacity + (size_t)n + 1) * 2;
+		char *data = realloc(dump->data, capacity);
+
+		if (data == NULL)
+			abort();
+
+		dump->data = data;
+		dump->capacity = capacity;
+	}
+
+	va_start(args, format);
+	vsnprintf(dump->data + dump->size, (size_t)n + 1, format, args);
+	va_end(args);
+
+	dump->size += (size_t)n;
+}
+
+/**
+ * Appends bytes as a quoted string, escaping anything but printable ASCII.
+ */
+static void
+dump_bytes(struct test_dump *dump, const char *data, size_t bytes)
+{
+	size_t i;
+
+	dump_printf(dump, "\"");
+
+	for (i = 0; i < bytes; ++i) {
+		unsigned char c = (unsigned char)data[i];
+
+		if (c < 0x20 || c >= 0x7f || c == '"' || c == '\\')
+			dump_printf(dump, "\\x%02x", c);
+		else
+			dump_printf(dump, "%c", c);
+	}
+
+	dump_printf(dump, "\"");
+}
+
+static void
+dump_string(struct test_dump *dump, const pancl_string *string)
+{
+	if (pancl_string_is_null(string)) {
+		dump_printf(dump, "(null)");
+		return;
+	}
+
+	dump_bytes(dump, pancl_string_data(string), pancl_string_bytes(string));
+	dump_printf(dump, "/%zu", pancl_string_codepoints(string));
+}
+
+#ifdef PANCL_NO_LOCATIONS
+#define DUMP_LOCATION(dump, node)  ((void)0)
+#else
+#define DUMP_LOCATION(dump, node)  dump_location((dump), &(node)->loc)
+
+static void
+dump_location(struct test_dump *dump, const struct pancl_location *loc)
+{
+	dump_printf(dump, "@%lu:%lu+%zu,%zu", (unsigned long)loc->line,
+		(unsigned long)loc->column, loc->offset, loc->length);
+}
+#endif
+
+static void dump_value(struct test_dump *dump,
+		const struct pancl_value *value, int depth);
+
+static void
+dump_tuple(struct test_dump *dump, const struct pancl_tuple *tuple,
+	int depth)
+{
+	size_t i;
+
+	dump_printf(dump, "(");
+	DUMP_LOCATION(dump, tuple);
+
+	for (i = 0; i < tuple->count; ++i) {
+		dump_printf(dump, " ");
+		dump_value(dump, pancl_tuple_at(tuple, i), depth);
+		dump_printf(dump, ",");
+	}
+
+	dump_printf(dump, ")");
+}
+
+static void
+dump_table_data(struct test_dump *dump, const struct pancl_table_data *td,
+	int depth)
+{
+	size_t i;
+
+	for (i = 0; i < td->count; ++i) {
+		const struct pancl_entry *entry = pancl_table_data_at(td, i);
+
+		dump_printf(dump, "%*s", depth * 2, "");
+		dump_string(dump, &(entry->name));
+		DUMP_LOCATION(dump, entry);
+		dump_printf(dump, " = ");
+		dump_value(dump, &(entry->value), depth);
+		dump_printf(dump, "\n");
+	}
+}
+
+static void
+dump_value(struct test_dump *dump, const struct pancl_value *value,
+	int depth)
+{
+	size_t i;
+	const struct pancl_array *array;
+	const struct pancl_custom *custom;
+	const struct pancl_table_data *table;
+
+	DUMP_LOCATION(dump, value);
+	dump_printf(dump, " ");
+
+	switch (value->type) {
+	case PANCL_TYPE_ARRAY:
+		array = pancl_value_array(value);
+		dump_printf(dump, "[");
+		DUMP_LOCATION(dump, array);
+
+		for (i = 0; i < array->count; ++i) {
+			dump_printf(dump, " ");
+			dump_value(dump, pancl_array_at(array, i), depth);
+			dump_printf(dump, ",");
+		}
+
+		dump_printf(dump, "]");
+		break;
+	case PANCL_TYPE_BOOLEAN:
+		dump_printf(dump, "bool %d", value->data.boolean);
+		break;
+	case PANCL_TYPE_CUSTOM:
+		custom = pancl_value_custom(value);
+		dump_printf(dump, "custom ");
+		dump_string(dump, &(custom->name));
+		DUMP_LOCATION(dump, custom);
+		dump_tuple(dump, &(custom->tuple), depth);
+		break;
+	case PANCL_TYPE_FLOATING:
+		dump_printf(dump, "float %.17g", value->data.floating);
+		break;
+	case PANCL_TYPE_INTEGER:
+		dump_printf(dump, "int %ld", (long)value->data.integer);
+		break;
+	case PANCL_TYPE_STRING:
+		dump_printf(dump, "string ");
+		dump_string(dump, &(value->data.string));
+		break;
+	case PANCL_TYPE_TABLE:
+		table = pancl_value_table(value);
+		dump_printf(dump, "{");
+		DUMP_LOCATION(dump, table);
+		dump_printf(dump, "\n");
+		dump_table_data(dump, table, depth + 1);
+		dump_printf(dump, "%*s}", depth * 2, "");
+		break;
+	case PANCL_TYPE_TUPLE:
+		dump_tuple(dump, pancl_value_tuple(value), depth);
+		break;
+	case PANCL_TYPE_OPT_INT8:
+		dump_printf(dump, "int8 %d", value->data.opt.int8);
+		break;
+	case PANCL_TYPE_OPT_UINT8:
+		dump_printf(dump, "uint8 %u", value->data.opt.uint8);
+		break;
+	case PANCL_TYPE_OPT_INT16:
+		dump_printf(dump, "int16 %d", value->data.opt.int16);
+		break;
+	case PANCL_TYPE_OPT_UINT16:
+		dump_printf(dump, "uint16 %u", value->data.opt.uint16);
+		break;
+	case PANCL_TYPE_OPT_INT32:
+		dump_printf(dump, "int32 %ld", (long)value->data.opt.int32);
+		break;
+	case PANCL_TYPE_OPT_UINT32:
+		dump_printf(dump, "uint32 %lu",
+			(unsigned long)value->data.opt.uint32);
+		break;
+	case PANCL_TYPE_OPT_INT64:
+		dump_printf(dump, "int64 %lld",
+			(long long)value->data.opt.int64);
+		break;
+	case PANCL_TYPE_OPT_UINT64:
+		dump_printf(dump, "uint64 %llu",
+			(unsigned long long)value->data.opt.uint64);
+		break;
+	default:
+		dump_printf(dump, "type %d", (int)value->type);
+		break;
+	}
+}
+
+/**
+ * Appends a table to a dump.
+ *
+ * @param[out] dump   Dump to append to
+ * @param[in] table   Table to describe
+ */
+void
+test_dump_table(struct test_dump *dump, const struct pancl_table *table)
+{
+	dump_printf(dump, "table ");
+	dump_string(dump, &(table->name));
+	DUMP_LOCATION(dump, table);
+	dump_printf(dump, "\n");
+	dump_table_data(dump, &(table->data), 1);
+}
+
+/**
+ * Parses every table from a context set up by pancl_parse_*() into a dump,
+ * followed by the error that stopped the parse, if any.
+ *
+ * @param[out] dump   Dump to append to
+ * @param[in] ctx     Context to parse from
+ */
+void
+test_dump_context(struct test_dump *dump, struct pancl_context *ctx)
+{
+	int err;
+	struct pancl_table table;
+
+	pancl_table_init(&table);
+
+	for (;;) {
+		err = pancl_get_next_table(ctx, &table);
+
+		if (err == PANCL_END_OF_INPUT)
+			break;
+
+		if (err != PANCL_SUCCESS) {
+			dump_printf(dump, "error %s @%lu:%lu\n", pancl_strerror(err),
+				(unsigned long)ctx->error_loc.line,
+				(unsigned long)ctx->error_loc.column);
+			break;
+		}
+
+		test_dump_table(dump, &table);
+		pancl_table_fini(&table);
+	}
+
+	pancl_table_fini(&table);
+}
+
+/**
+ * Parses @p input through one of the pancl_parse_*() entry points into a
+ * dump.
+ *
+ * @param[out] dump          Dump to append to
+ * @param[in] source         Entry point to use
+ * @param[in] input          Input to parse
+ * @param[in] size           Length of @p input in bytes
+ * @param[in] buffer_size    pancl_context_set_buffer_size() argument
+ */
+void
+test_dump_parse(struct test_dump *dump, enum test_source source,
+	const char *input, size_t size, size_t buffer_size)
+{
+	int err;
+	FILE *f = NULL;
+	struct pancl_context ctx;
+
+	pancl_context_init(&ctx);
+	err = pancl_context_set_buffer_size(&ctx, buffer_size);
+
+	if (err == PANCL_SUCCESS && source == TEST_BUFFER) {
+		err = pancl_parse_buffer(&ctx, input, size);
+	}
+	else if (err == PANCL_SUCCESS) {
+		f = test_file(input, size);
+
+		if (source == TEST_FILE)
+			err = pancl_parse_file(&ctx, f);
+		else
+			err = pancl_parse_fd(&ctx, fileno(f));
+	}
+
+	if (err == PANCL_SUCCESS)
+		test_dump_context(dump, &ctx);
+	else
+		dump_printf(dump, "setup error %s\n", pancl_strerror(err));
+
+	pancl_context_fini(&ctx);
+
+	if (f != NULL)
+		fclose(f);
+}
+
+// vim:ts=4:sw=4:autoindent
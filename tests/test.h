@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef H_PANCL_TEST
+#define H_PANCL_TEST
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "pancl/pancl.h"
+
+/**
+ * @file test.h
+ * @brief Helpers shared by the programs in tests/ (see `make test`).
+ *
+ * Every test program parses some input, turns the resulting tables (or the
+ * error) into text with test_dump_parse() and compares that text, so the
+ * same input can be checked through every pancl_parse_*() entry point.
+ */
+
+/**
+ * Records a failure, with the file and line, unless @p cond holds.
+ */
+#define TEST_CHECK(cond) \
+	test_check((cond), #cond, __FILE__, __LINE__)
+
+/**
+ * Where test_dump_parse() reads its input from.
+ */
+enum test_source {
+	TEST_BUFFER, /**< pancl_parse_buffer() */
+	TEST_FILE, /**< pancl_parse_file() on a temporary file */
+	TEST_FD /**< pancl_parse_fd() on a temporary file */
+};
+
+/**
+ * Text describing every table parsed from an input, or the error that
+ * stopped the parse.
+ */
+struct test_dump {
+	char *data; /**< NUL-terminated text */
+	size_t size; /**< Length of @p data */
+	size_t capacity; /**< Allocated size of @p data */
+};
+
+void test_check(bool ok, const char *what, const char *file, int line);
+int test_finish(const char *name);
+
+FILE *test_file(const char *input, size_t size);
+bool test_string_value(const char *input, size_t size, const char *value,
+		size_t bytes);
+
+void test_dump_init(struct test_dump *dump);
+void test_dump_fini(struct test_dump *dump);
+bool test_dump_equal(const struct test_dump *a, const struct test_dump *b);
+void test_dump_table(struct test_dump *dump,
+		const struct pancl_table *table);
+void test_dump_context(struct test_dump *dump, struct pancl_context *ctx);
+void test_dump_parse(struct test_dump *dump, enum test_source source,
+		const char *input, size_t size, size_t buffer_size);
+
+#endif /* H_PANCL_TEST */
+// vim:ts=4:sw=4:autoindent
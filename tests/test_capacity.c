@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_capacity.c
+ * @brief Containers grow geometrically and pancl_table_shrink_to_fit()
+ * trims them without changing their contents.
+ */
+
+
+/**
+ * Number of elements in the large containers.
+ */
+#define COUNT  (1000)
+
+static void check_value_fit(const struct pancl_value *value);
+
+static void
+check_table_data_fit(const struct pancl_table_data *td)
+{
+	size_t i;
+
+	TEST_CHECK(td->capacity == td->count);
+
+	for (i = 0; i < td->count; ++i)
+		check_value_fit(&(pancl_table_data_at(td, i)->value));
+}
+
+static void
+check_tuple_fit(const struct pancl_tuple *tuple)
+{
+	size_t i;
+
+	TEST_CHECK(tuple->capacity == tuple->count);
+
+	for (i = 0; i < tuple->count; ++i)
+		check_value_fit(pancl_tuple_at(tuple, i));
+}
+
+/**
+ * Checks that every container in @p value is exactly as large as it needs
+ * to be.
+ */
+static void
+check_value_fit(const struct pancl_value *value)
+{
+	size_t i;
+	const struct pancl_array *array;
+
+	switch (value->type) {
+	case PANCL_TYPE_ARRAY:
+		array = pancl_value_array(value);
+		TEST_CHECK(array->capacity == array->count);
+
+		for (i = 0; i < array->count; ++i)
+			check_value_fit(pancl_array_at(array, i));
+		break;
+	case PANCL_TYPE_CUSTOM:
+		check_tuple_fit(&(pancl_value_custom(value)->tuple));
+		break;
+	case PANCL_TYPE_TABLE:
+		check_table_data_fit(pancl_value_table(value));
+		break;
+	case PANCL_TYPE_TUPLE:
+		check_tuple_fit(pancl_value_tuple(value));
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Builds a table with large and small containers of every kind.
+ *
+ * @param[out] size   Length of the document
+ *
+ * @return Returns the document, to be free()d.
+ */
+static char *
+document(size_t *size)
+{
+	size_t used = 0;
+	int i;
+	char *text = malloc(64 * COUNT);
+
+	if (text == NULL)
+		abort();
+
+	used += (size_t)sprintf(text + used, "a = [");
+
+	for (i = 0; i < COUNT; ++i)
+		used += (size_t)sprintf(text + used, "%d, ", i);
+
+	used += (size_t)sprintf(text + used, "]\nt = (");
+
+	for (i = 0; i < COUNT; ++i)
+		used += (size_t)sprintf(text + used, "\"%d\", ", i);
+
+	used += (size_t)sprintf(text + used, ")\nc = { x = Foo(1, 2, 3), "
+		"y = [[1], [2, 3], []] }\n");
+
+	for (i = 0; i < COUNT; ++i)
+		used += (size_t)sprintf(text + used, "k%d = %d\n", i, i);
+
+	*size = used;
+	return text;
+}
+
+static void
+test_shrink(unsigned int flags)
+{
+	size_t size;
+	char *text = document(&size);
+	struct pancl_context ctx;
+	struct pancl_table table;
+	struct test_dump before;
+	struct test_dump after;
+	const struct pancl_value *value;
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+	ctx.flags = flags;
+
+	TEST_CHECK(pancl_parse_buffer(&ctx, text, size) == PANCL_SUCCESS);
+	TEST_CHECK(pancl_get_next_table(&ctx, &table) == PANCL_SUCCESS);
+	TEST_CHECK(table.data.count == COUNT + 3);
+
+	/* Grown by doubling, not one element at a time. */
+	value = &(pancl_table_data_at(&(table.data), 0)->value);
+	TEST_CHECK(pancl_value_array(value)->count == COUNT);
+	TEST_CHECK(pancl_value_array(value)->capacity == 1024);
+	TEST_CHECK(table.data.capacity == 1024);
+
+	test_dump_init(&before);
+	test_dump_init(&after);
+
+	test_dump_table(&before, &table);
+	TEST_CHECK(pancl_table_shrink_to_fit(&table) == PANCL_SUCCESS);
+	test_dump_table(&after, &table);
+	TEST_CHECK(test_dump_equal(&before, &after));
+
+	/* Arenas can't give anything back. */
+	if ((flags & PANCL_PARSE_ARENA) == 0)
+		check_table_data_fit(&(table.data));
+
+	test_dump_fini(&before);
+	test_dump_fini(&after);
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+	free(text);
+}
+
+int
+main(void)
+{
+	test_shrink(0);
+	test_shrink(PANCL_PARSE_RECYCLE);
+	test_shrink(PANCL_PARSE_ARENA);
+	return test_finish("test_capacity");
+}
+
+// vim:ts=4:sw=4:autoindent
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_errors.c
+ * @brief Errors have to point at the token that caused them.
+ */
+
+
+/**
+ * Parses @p input from memory and checks the error it fails with.
+ *
+ * @param[in] input    Input to parse
+ * @param[in] error    Expected PANCL_ERROR_*
+ * @param[in] line     Expected pancl_context.error_loc line
+ * @param[in] column   Expected pancl_context.error_loc column
+ * @param[in] token    Expected pancl_context.error_token
+ */
+static void
+check_error(const char *input, int error, unsigned long line,
+	unsigned long column, const char *token)
+{
+	int err;
+	struct pancl_context ctx;
+	struct pancl_table table;
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+
+	err = pancl_parse_string(&ctx, input);
+	TEST_CHECK(err == PANCL_SUCCESS);
+
+	err = pancl_get_next_table(&ctx, &table);
+	TEST_CHECK(err == error);
+	TEST_CHECK(ctx.error_loc.line == line);
+#if !defined(PANCL_NO_LOCATIONS)
+	/* Without locations the column is wherever the lexer stopped. */
+	TEST_CHECK(ctx.error_loc.column == column);
+#else
+	(void)column;
+#endif
+	TEST_CHECK(ctx.error_token != NULL
+		&& strcmp(ctx.error_token->data, token) == 0);
+
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+}
+
+static void
+test_float_base(void)
+{
+	/* An out of range base is reported at the base, not wherever the
+	 * previous error happened to be.
+	 */
+	check_error("a = ::Float(\"1.5\", 99999999999)\n",
+		PANCL_ERROR_STR_TO_INT_RANGE, 0, 20, "99999999999");
+
+	/* So is a valid integer that isn't a base ::Float accepts. */
+	check_error("a = ::Float(\"1.5\", 7)\n",
+		PANCL_ERROR_STR_TO_FLOAT_BASE, 0, 20, "7");
+	check_error("a = ::Float(\"1.5\", 0xFFFFFFFF)\n",
+		PANCL_ERROR_STR_TO_FLOAT_BASE, 0, 20, "0xFFFFFFFF");
+	check_error("a = ::Float(\"1.5\",\n  -16)\n",
+		PANCL_ERROR_STR_TO_FLOAT_BASE, 1, 3, "-16");
+}
+
+int
+main(void)
+{
+	test_float_base();
+	return test_finish("test_errors");
+}
+
+// vim:ts=4:sw=4:autoindent
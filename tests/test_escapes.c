@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdio.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_escapes.c
+ * @brief Escape sequences in double-quoted strings.
+ */
+
+
+#define CHECK_STRING(input, value) \
+	TEST_CHECK(test_string_value(input, sizeof(input) - 1, \
+		value, sizeof(value) - 1))
+
+/**
+ * Octal escapes take up to three digits, and nothing past them.
+ */
+static void
+test_octal(void)
+{
+	CHECK_STRING("a = \"\\101\"", "A");
+	CHECK_STRING("a = \"\\1234\"", "S4");
+	CHECK_STRING("a = \"\\7\"", "\a");
+	CHECK_STRING("a = \"x\\0y\"", "x\0y");
+	CHECK_STRING("a = \"\\18\"", "\0018");
+	CHECK_STRING("a = \"\\377\"", "\xc3\xbf");
+}
+
+/**
+ * Hex escapes are exact, except \x which takes one or two digits.
+ */
+static void
+test_hex(void)
+{
+	CHECK_STRING("a = \"\\x41\"", "A");
+	CHECK_STRING("a = \"\\x4g\"", "\x04g");
+	CHECK_STRING("a = \"\\u00e9\"", "\xc3\xa9");
+	CHECK_STRING("a = \"\\U0001F600\"", "\xf0\x9f\x98\x80");
+}
+
+int
+main(void)
+{
+	test_octal();
+	test_hex();
+	return test_finish("test_escapes");
+}
+
+// vim:ts=4:sw=4:autoindent
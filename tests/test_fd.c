@@ -0,0 +1,292 @@
+/* SPDX-License-Identifier: MIT */
+/* fileno(), pipe(2) */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pancl/pancl.h"
+#include "internal.h"
+#include "test.h"
+
+/**
+ * @file test_fd.c
+ * @brief pancl_parse_fd() and the read buffer sizing behind it.
+ *
+ * Whatever the descriptor is and however the buffer ends up sized, the
+ * tables have to be the same as when parsing the input from memory.
+ */
+
+
+/**
+ * Largest read size picked from a regular file, as documented for
+ * pancl_context_set_buffer_size().
+ */
+#define LARGEST_READ  ((size_t)1 << 20)
+
+/**
+ * Read size used for pipes and small files, as documented for
+ * pancl_context_set_buffer_size().
+ */
+#define SMALLEST_READ  ((size_t)8192)
+
+static const char document[] =
+	"a = 1\n"
+	"b = \"two \xe6\xbc\xa2\"\n"
+	"[t]\n"
+	"c = [1.5, (true, 'x')]\n";
+
+
+/**
+ * Parses everything readable from @p fd into a dump.
+ *
+ * @param[out] dump          Dump to append to
+ * @param[in] fd             Descriptor to parse
+ * @param[in] buffer_size    pancl_context_set_buffer_size() argument
+ *
+ * @return Returns pancl_context.buffer_size as set up for @p fd.
+ */
+static size_t
+dump_fd(struct test_dump *dump, int fd, size_t buffer_size)
+{
+	size_t allocated;
+	struct pancl_context ctx;
+
+	pancl_context_init(&ctx);
+	TEST_CHECK(pancl_context_set_buffer_size(&ctx, buffer_size)
+		== PANCL_SUCCESS);
+	TEST_CHECK(pancl_parse_fd(&ctx, fd) == PANCL_SUCCESS);
+
+	allocated = ctx.buffer_size;
+	test_dump_context(dump, &ctx);
+	pancl_context_fini(&ctx);
+	return allocated;
+}
+
+/**
+ * Parses @p input from a pipe and checks it against parsing from memory.
+ *
+ * @param[in] input          Input to parse, has to fit in the pipe
+ * @param[in] size           Length of @p input in bytes
+ * @param[in] buffer_size    pancl_context_set_buffer_size() argument
+ *
+ * @return Returns pancl_context.buffer_size as set up for the pipe.
+ */
+static size_t
+check_pipe(const char *input, size_t size, size_t buffer_size)
+{
+	int fds[2];
+	size_t allocated;
+	struct test_dump expected;
+	struct test_dump dump;
+
+	if (pipe(fds) != 0 || write(fds[1], input, size) != (ssize_t)size) {
+		perror("pipe");
+		exit(EXIT_FAILURE);
+	}
+
+	close(fds[1]);
+
+	test_dump_init(&expected);
+	test_dump_init(&dump);
+	test_dump_parse(&expected, TEST_BUFFER, input, size, 0);
+
+	allocated = dump_fd(&dump, fds[0], buffer_size);
+	TEST_CHECK(test_dump_equal(&expected, &dump));
+
+	test_dump_fini(&expected);
+	test_dump_fini(&dump);
+	close(fds[0]);
+	return allocated;
+}
+
+/**
+ * Parses @p input from a regular file and checks it against parsing from
+ * memory.
+ *
+ * @param[in] input          Input to parse
+ * @param[in] size           Length of @p input in bytes
+ * @param[in] buffer_size    pancl_context_set_buffer_size() argument
+ *
+ * @return Returns pancl_context.buffer_size as set up for the file.
+ */
+static size_t
+check_file(const char *input, size_t size, size_t buffer_size)
+{
+	size_t allocated;
+	FILE *f = test_file(input, size);
+	struct test_dump expected;
+	struct test_dump dump;
+
+	test_dump_init(&expected);
+	test_dump_init(&dump);
+	test_dump_parse(&expected, TEST_BUFFER, input, size, 0);
+
+	allocated = dump_fd(&dump, fileno(f), buffer_size);
+	TEST_CHECK(test_dump_equal(&expected, &dump));
+
+	test_dump_fini(&expected);
+	test_dump_fini(&dump);
+	fclose(f);
+	return allocated;
+}
+
+/**
+ * Builds a document of @p size bytes or a little more.
+ *
+ * @param[in] size    Smallest length wanted
+ * @param[out] bytes  Actual length
+ *
+ * @return Returns the document, to be free()d.
+ */
+static char *
+large_document(size_t size, size_t *bytes)
+{
+	size_t used = 0;
+	unsigned long i;
+	char *text = malloc(size + 64);
+
+	if (text == NULL)
+		abort();
+
+	for (i = 0; used < size; ++i) {
+		used += (size_t)sprintf(text + used,
+			"[t%lu]\nk = %lu\ns = \"\xe2\x98\x83\"\n", i, i);
+	}
+
+	*bytes = used;
+	return text;
+}
+
+static void
+test_pipe(void)
+{
+	size_t allocated;
+
+	/* Pipes can't be sized up front, they get the default. */
+	allocated = check_pipe(document, sizeof(document) - 1, 0);
+	TEST_CHECK(allocated >= REFILL_HEADROOM + SMALLEST_READ);
+	TEST_CHECK(allocated <= REFILL_HEADROOM + LARGEST_READ);
+
+	/* Many short reads. */
+	allocated = check_pipe(document, sizeof(document) - 1,
+		PANCL_BUFFER_SIZE_MIN);
+	TEST_CHECK(allocated == REFILL_HEADROOM + PANCL_BUFFER_SIZE_MIN);
+}
+
+static void
+test_empty(void)
+{
+	int err;
+	FILE *f = test_file("", 0);
+	struct pancl_context ctx;
+	struct pancl_table table;
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+
+	TEST_CHECK(pancl_parse_fd(&ctx, fileno(f)) == PANCL_SUCCESS);
+	TEST_CHECK(ctx.buffer_size >= REFILL_HEADROOM + SMALLEST_READ);
+
+	err = pancl_get_next_table(&ctx, &table);
+	TEST_CHECK(err == PANCL_END_OF_INPUT);
+
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+	fclose(f);
+
+	TEST_CHECK(check_pipe("", 0, 0) >= REFILL_HEADROOM + SMALLEST_READ);
+}
+
+static void
+test_file_sizes(void)
+{
+	char *text;
+	size_t bytes;
+	size_t allocated;
+
+	/* Small files still get the default. */
+	allocated = check_file(document, sizeof(document) - 1, 0);
+	TEST_CHECK(allocated >= REFILL_HEADROOM + SMALLEST_READ);
+
+	/* Larger ones are read in one go... */
+	text = large_document(3 * SMALLEST_READ, &bytes);
+	allocated = check_file(text, bytes, 0);
+	TEST_CHECK(allocated >= REFILL_HEADROOM + bytes);
+	TEST_CHECK(allocated <= REFILL_HEADROOM + LARGEST_READ);
+	free(text);
+
+	/* ...up to a point. */
+	text = large_document(2 * LARGEST_READ + 1, &bytes);
+	allocated = check_file(text, bytes, 0);
+	TEST_CHECK(allocated == REFILL_HEADROOM + LARGEST_READ);
+	free(text);
+}
+
+static void
+test_buffer_size(void)
+{
+	char *text;
+	size_t bytes;
+	struct pancl_context ctx;
+
+	/* An explicit size wins over whatever the input suggests. */
+	text = large_document(3 * SMALLEST_READ, &bytes);
+	TEST_CHECK(check_file(text, bytes, 16) == REFILL_HEADROOM + 16);
+	TEST_CHECK(check_file(text, bytes, 3 * LARGEST_READ)
+		== REFILL_HEADROOM + 3 * LARGEST_READ);
+	TEST_CHECK(check_pipe(document, sizeof(document) - 1, 100000)
+		== REFILL_HEADROOM + 100000);
+	free(text);
+
+	pancl_context_init(&ctx);
+	TEST_CHECK(pancl_context_set_buffer_size(&ctx, PANCL_BUFFER_SIZE_MIN - 1)
+		== PANCL_ERROR_ARG_INVALID);
+	TEST_CHECK(pancl_context_set_buffer_size(NULL, 0)
+		== PANCL_ERROR_ARG_INVALID);
+	pancl_context_fini(&ctx);
+}
+
+static void
+test_offset(void)
+{
+	FILE *f = test_file(document, sizeof(document) - 1);
+	struct test_dump expected;
+	struct test_dump dump;
+
+	test_dump_init(&expected);
+	test_dump_parse(&expected, TEST_BUFFER, document, sizeof(document) - 1,
+		0);
+
+	/* Somewhere in the middle of the first line and at the end. */
+	TEST_CHECK(lseek(fileno(f), 3, SEEK_SET) == 3);
+	test_dump_init(&dump);
+	dump_fd(&dump, fileno(f), 0);
+	TEST_CHECK(test_dump_equal(&expected, &dump));
+	test_dump_fini(&dump);
+
+	TEST_CHECK(lseek(fileno(f), 0, SEEK_END) != (off_t)-1);
+	test_dump_init(&dump);
+	dump_fd(&dump, fileno(f), PANCL_BUFFER_SIZE_MIN);
+	TEST_CHECK(test_dump_equal(&expected, &dump));
+	test_dump_fini(&dump);
+
+	test_dump_fini(&expected);
+	fclose(f);
+}
+
+int
+main(void)
+{
+	test_pipe();
+	test_empty();
+	test_file_sizes();
+	test_buffer_size();
+	test_offset();
+	return test_finish("test_fd");
+}
+
+// vim:ts=4:sw=4:autoindent
@@ -0,0 +1,220 @@
+/* SPDX-License-Identifier: MIT */
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "parser/str_to_float.h"
+#include "test.h"
+
+/**
+ * @file test_float.c
+ * @brief Correct rounding of floating point conversions at the edges of the
+ * range and of each conversion path.
+ */
+
+
+/**
+ * A conversion and its expected result.
+ */
+struct conversion {
+	const char *text; /**< Input */
+	int base; /**< Base passed to str_to_double_base() */
+	int error; /**< Expected return value */
+	double value; /**< Expected value if error == PANCL_SUCCESS */
+};
+
+static const struct conversion conversions[] = {
+	/* Around the smallest subnormal: below half of it is zero. */
+	{ "2.4703282292062327e-324", 10, PANCL_ERROR_STR_TO_FLOAT_UNDERFLOW, 0 },
+	{ "2.4703282292062328e-324", 10, PANCL_SUCCESS, 0x1p-1074 },
+	{ "4.9406564584124654e-324", 10, PANCL_SUCCESS, 0x1p-1074 },
+	{ "-5e-324", 10, PANCL_SUCCESS, -0x1p-1074 },
+	{ "1e-400", 10, PANCL_ERROR_STR_TO_FLOAT_UNDERFLOW, 0 },
+	{ "0e-400", 10, PANCL_SUCCESS, 0 },
+
+	/* Between the largest subnormal and the smallest normal. */
+	{ "2.2250738585072011e-308", 10, PANCL_SUCCESS,
+		0x0.fffffffffffffp-1022 },
+	{ "2.2250738585072012e-308", 10, PANCL_SUCCESS, 0x1p-1022 },
+
+	/* Around DBL_MAX: past halfway to 2^1024 overflows. */
+	{ "1.7976931348623157e308", 10, PANCL_SUCCESS, 0x1.fffffffffffffp1023 },
+	{ "1.7976931348623158e308", 10, PANCL_SUCCESS, 0x1.fffffffffffffp1023 },
+	{ "1.7976931348623159e308", 10, PANCL_ERROR_STR_TO_FLOAT_OVERFLOW, 0 },
+	{ "1e309", 10, PANCL_ERROR_STR_TO_FLOAT_OVERFLOW, 0 },
+
+	/* Ties go to the even mantissa. */
+	{ "9007199254740993", 10, PANCL_SUCCESS, 0x1p53 },
+	{ "9007199254740995", 10, PANCL_SUCCESS, 0x1.0000000000002p53 },
+	{ "1.00000000000000011102230246251565404236316680908203125", 10,
+		PANCL_SUCCESS, 1.0 },
+	{ "1.00000000000000033306690738754696212708950042724609375", 10,
+		PANCL_SUCCESS, 0x1.0000000000002p0 },
+
+	/* More than 19 digits: only whether the dropped ones are all zero
+	 * decides a tie.
+	 */
+	{ "1.00000000000000011102230246251565404236316680908203126", 10,
+		PANCL_SUCCESS, 0x1.0000000000001p0 },
+	{ "9007199254740993.0000000000000000000", 10, PANCL_SUCCESS, 0x1p53 },
+	{ "9007199254740993.0000000000000000001", 10, PANCL_SUCCESS,
+		0x1.0000000000001p53 },
+	{ "123456789012345678901234567890", 10, PANCL_SUCCESS,
+		0x1.8ee90ff6c373ep96 },
+	{ "0.1", 10, PANCL_SUCCESS, 0x1.999999999999ap-4 },
+
+	/* Hexadecimal, rounded when it has more than 53 bits. */
+	{ "0x5c3af7.A0Cf6EeAp-1046", 0, PANCL_SUCCESS,
+		0x0.5c3af7a0cf6efp-1022 },
+	{ "5c3af7.A0Cf6EeAp-1046", 16, PANCL_SUCCESS, 0x0.5c3af7a0cf6efp-1022 },
+	{ "0x1.00000000000008p0", 0, PANCL_SUCCESS, 1.0 },
+	{ "0x1.00000000000018p0", 0, PANCL_SUCCESS, 0x1.0000000000002p0 },
+	{ "0x1.000000000000081p0", 0, PANCL_SUCCESS, 0x1.0000000000001p0 },
+	{ "0x1.8p-1075", 0, PANCL_SUCCESS, 0x1p-1074 },
+	{ "0x1p-1075", 0, PANCL_ERROR_STR_TO_FLOAT_UNDERFLOW, 0 },
+	{ "0x1.fffffffffffff8p1023", 0, PANCL_ERROR_STR_TO_FLOAT_OVERFLOW, 0 },
+
+	/* Not numbers, or not in that base. */
+	{ "1.5", 7, PANCL_ERROR_STR_TO_FLOAT_BASE, 0 },
+	{ "1,5", 10, PANCL_ERROR_STR_TO_FLOAT_CHAR, 0 },
+	{ "0x1p3", 10, PANCL_ERROR_STR_TO_FLOAT_CHAR, 0 }
+};
+
+/**
+ * Checks that two doubles have the same bits, so that -0.0 != 0.0.
+ */
+static int
+same_double(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static void
+test_conversions(void)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(conversions) / sizeof(conversions[0]); ++i) {
+		const struct conversion *c = &(conversions[i]);
+		double d = 0;
+		int err = str_to_double_base(&d, c->text, strlen(c->text),
+			c->base);
+
+		if (err != c->error
+				|| (err == PANCL_SUCCESS && !same_double(d, c->value))) {
+			fprintf(stderr, "%s: got %d %a\n", c->text, err, d);
+			TEST_CHECK(0);
+		}
+	}
+}
+
+/**
+ * Compares against strtod() in the "C" locale for pseudo-random inputs of
+ * up to 25 digits, which take every conversion path.
+ */
+static void
+test_strtod(void)
+{
+	uint_least32_t state = 12345;
+	int i;
+
+	for (i = 0; i < 100000; ++i) {
+		char text[64];
+		int digits;
+		int n;
+		int j;
+		double expected;
+		double d = 0;
+		int err;
+
+		state = state * 1103515245u + 12345u;
+		digits = 1 + (int)((state >> 16) % 25);
+		n = 0;
+
+		for (j = 0; j < digits; ++j) {
+			state = state * 1103515245u + 12345u;
+			text[n++] = (char)('0' + (j == 0 ? 1 : 0)
+				+ (int)((state >> 16) % (j == 0 ? 9 : 10)));
+		}
+
+		state = state * 1103515245u + 12345u;
+		n += sprintf(text + n, "e%d",
+			(int)((state >> 16) % 680) - 350);
+
+		expected = strtod(text, NULL);
+		err = str_to_double(&d, text, (size_t)n);
+
+		if (isinf(expected))
+			TEST_CHECK(err == PANCL_ERROR_STR_TO_FLOAT_OVERFLOW);
+		else if (expected == 0)
+			TEST_CHECK(err == PANCL_ERROR_STR_TO_FLOAT_UNDERFLOW);
+		else if (err != PANCL_SUCCESS || !same_double(d, expected)) {
+			fprintf(stderr, "%s: got %d %a, expected %a\n", text, err, d,
+				expected);
+			TEST_CHECK(0);
+		}
+	}
+}
+
+/**
+ * A decimal comma locale changes nothing, in the converter or the parser.
+ */
+static void
+test_locale(void)
+{
+	static const char input[] = "a = 1.5\nb = ::Float(\"2.25\")\n";
+	static const char *const names[] = {
+		"de_DE.UTF-8", "de_DE.utf8", "de_DE"
+	};
+	size_t i;
+	double d = 0;
+	struct pancl_context ctx;
+	struct pancl_table table;
+
+	for (i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+		if (setlocale(LC_NUMERIC, names[i]) != NULL)
+			break;
+	}
+
+	if (i == sizeof(names) / sizeof(names[0])) {
+		printf("test_float: no de_DE locale, skipping locale check\n");
+		return;
+	}
+
+	TEST_CHECK(str_to_double(&d, "1.5", 3) == PANCL_SUCCESS && d == 1.5);
+	TEST_CHECK(str_to_double(&d, "1,5", 3)
+		== PANCL_ERROR_STR_TO_FLOAT_CHAR);
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+	TEST_CHECK(pancl_parse_buffer(&ctx, input, sizeof(input) - 1)
+		== PANCL_SUCCESS);
+	TEST_CHECK(pancl_get_next_table(&ctx, &table) == PANCL_SUCCESS);
+	TEST_CHECK(table.data.count == 2);
+
+	if (table.data.count == 2) {
+		TEST_CHECK(pancl_table_data_at(&(table.data), 0)->value.data.floating
+			== 1.5);
+		TEST_CHECK(pancl_table_data_at(&(table.data), 1)->value.data.floating
+			== 2.25);
+	}
+
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+	setlocale(LC_NUMERIC, "C");
+}
+
+int
+main(void)
+{
+	test_conversions();
+	test_strtod();
+	test_locale();
+	return test_finish("test_float");
+}
+
+// vim:ts=4:sw=4:autoindent
@@ -0,0 +1,538 @@
+/* SPDX-License-Identifier: MIT */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "parser/str_to_int.h"
+#include "test.h"
+
+/**
+ * @file test_int.c
+ * @brief Fixed width integer conversion, at the edges of every width and
+ * base and against a digit by digit reference.
+ */
+
+
+/**
+ * The fixed width conversions, in the order of types[].
+ */
+enum width {
+	INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64
+};
+
+/**
+ * Limits of a conversion.
+ */
+struct type {
+	const char *name; /**< Custom type name */
+	bool is_signed; /**< Whether '-' is accepted */
+	uint64_t neg_max; /**< Magnitude of the minimum */
+	uint64_t umax; /**< Largest accepted value */
+};
+
+static const struct type types[] = {
+	{ "::Int8", true, 128, UINT8_MAX },
+	{ "::Uint8", false, 0, UINT8_MAX },
+	{ "::Int16", true, 32768, UINT16_MAX },
+	{ "::Uint16", false, 0, UINT16_MAX },
+	{ "::Int32", true, UINT64_C(2147483648), UINT32_MAX },
+	{ "::Uint32", false, 0, UINT32_MAX },
+	{ "::Int64", true, UINT64_C(9223372036854775808), UINT64_MAX },
+	{ "::Uint64", false, 0, UINT64_MAX }
+};
+
+#define TYPE_COUNT  (sizeof(types) / sizeof(types[0]))
+
+/**
+ * Converts @p str with the str_to_*() function for @p width.
+ *
+ * @param[out] bits   Result, sign extended to 64 bits for signed types
+ *
+ * @return Returns what the conversion returned.
+ */
+static int
+convert(enum width width, const char *str, int base, uint64_t *bits)
+{
+	int err = PANCL_ERROR_INTERNAL;
+	union {
+		int_least8_t i8;
+		uint_least8_t u8;
+		int_least16_t i16;
+		uint_least16_t u16;
+		int_least32_t i32;
+		uint_least32_t u32;
+		int_least64_t i64;
+		uint_least64_t u64;
+	} r;
+
+	*bits = 0;
+
+	switch (width) {
+	case INT8:
+		if ((err = str_to_int8(&r.i8, str, base)) == PANCL_SUCCESS)
+			*bits = (uint64_t)(int_least64_t)r.i8;
+		break;
+	case UINT8:
+		if ((err = str_to_uint8(&r.u8, str, base)) == PANCL_SUCCESS)
+			*bits = r.u8;
+		break;
+	case INT16:
+		if ((err = str_to_int16(&r.i16, str, base)) == PANCL_SUCCESS)
+			*bits = (uint64_t)(int_least64_t)r.i16;
+		break;
+	case UINT16:
+		if ((err = str_to_uint16(&r.u16, str, base)) == PANCL_SUCCESS)
+			*bits = r.u16;
+		break;
+	case INT32:
+		if ((err = str_to_int32(&r.i32, str, base)) == PANCL_SUCCESS)
+			*bits = (uint64_t)(int_least64_t)r.i32;
+		break;
+	case UINT32:
+		if ((err = str_to_uint32(&r.u32, str, base)) == PANCL_SUCCESS)
+			*bits = r.u32;
+		break;
+	case INT64:
+		if ((err = str_to_int64(&r.i64, str, base)) == PANCL_SUCCESS)
+			*bits = (uint64_t)r.i64;
+		break;
+	case UINT64:
+		if ((err = str_to_uint64(&r.u64, str, base)) == PANCL_SUCCESS)
+			*bits = r.u64;
+		break;
+	}
+
+	return err;
+}
+
+/**
+ * Truncates @p v to @p width, sign extending it again for signed types.
+ */
+static uint64_t
+narrow(enum width width, uint64_t v)
+{
+	switch (width) {
+	case INT8:
+		return (uint64_t)(int_least64_t)(int_least8_t)(v & 0xff);
+	case UINT8:
+		return v & 0xff;
+	case INT16:
+		return (uint64_t)(int_least64_t)(int_least16_t)(v & 0xffff);
+	case UINT16:
+		return v & 0xffff;
+	case INT32:
+		return (uint64_t)(int_least64_t)(int_least32_t)(v & 0xffffffff);
+	case UINT32:
+		return v & 0xffffffff;
+	default:
+		return v;
+	}
+}
+
+/**
+ * Digit by digit conversion, as the library did before it converted whole
+ * chunks at once.
+ */
+static int
+reference(enum width width, const char *str, int base, uint64_t *bits)
+{
+	const struct type *type = &(types[width]);
+	bool negative = false;
+	uint64_t max = type->umax;
+	uint64_t r = 0;
+
+	if (str[0] == '-' && type->is_signed) {
+		negative = true;
+		max = type->neg_max;
+		++str;
+	}
+	else if (str[0] == '+') {
+		++str;
+	}
+
+	if (base < 0 || base == 1 || base > 36)
+		return PANCL_ERROR_STR_TO_INT_BASE;
+
+	if (str[0] == '\0')
+		return PANCL_ERROR_ARG_INVALID;
+
+	if (str[0] == '0' && str[1] != '\0') {
+		int prefix = 0;
+
+		if (str[1] == 'x' || str[1] == 'X')
+			prefix = 16;
+		else if (str[1] == 'o' || str[1] == 'O')
+			prefix = 8;
+		else if (str[1] == 'b' || str[1] == 'B')
+			prefix = 2;
+
+		if (prefix != 0) {
+			if (base != 0 && base != prefix)
+				return PANCL_ERROR_STR_TO_INT_CHAR;
+
+			base = prefix;
+			str += 2;
+		}
+	}
+
+	if (base == 0)
+		base = 10;
+
+	for (; *str != '\0'; ++str) {
+		int v;
+
+		if (*str >= '0' && *str <= '9')
+			v = *str - '0';
+		else if (*str >= 'a' && *str <= 'z')
+			v = *str - 'a' + 10;
+		else if (*str >= 'A' && *str <= 'Z')
+			v = *str - 'A' + 10;
+		else
+			return PANCL_ERROR_STR_TO_INT_CHAR;
+
+		if (v >= base)
+			return PANCL_ERROR_STR_TO_INT_CHAR;
+
+		if (r > max / (uint64_t)base
+				|| (r == max / (uint64_t)base
+					&& (uint64_t)v > max % (uint64_t)base))
+			return PANCL_ERROR_STR_TO_INT_RANGE;
+
+		r = r * (uint64_t)base + (uint64_t)v;
+	}
+
+	*bits = narrow(width, negative ? (uint64_t)0 - r : r);
+	return PANCL_SUCCESS;
+}
+
+/**
+ * Checks one conversion against the expected result.
+ */
+static void
+check(enum width width, const char *str, int base, int error,
+	uint64_t expected)
+{
+	uint64_t bits;
+	int err = convert(width, str, base, &bits);
+
+	if (err != error || (err == PANCL_SUCCESS && bits != expected)) {
+		fprintf(stderr, "%s(\"%s\", %d): got %d %llx, expected %d %llx\n",
+			types[width].name, str, base, err, (unsigned long long)bits,
+			error, (unsigned long long)expected);
+		TEST_CHECK(0);
+	}
+}
+
+/**
+ * Formats @p v in @p base after @p prefix, alternating the case of letters
+ * if @p mixed.
+ */
+static void
+format(char *buf, const char *prefix, uint64_t v, int base, bool mixed)
+{
+	char digits[72];
+	size_t n = 0;
+	size_t i;
+
+	do {
+		int d = (int)(v % (uint64_t)base);
+		char c = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+
+		if (d >= 10 && !(mixed && n % 2 == 0))
+			c = (char)(c - 'A' + 'a');
+
+		digits[n++] = c;
+		v /= (uint64_t)base;
+	} while (v != 0);
+
+	strcpy(buf, prefix);
+	buf += strlen(prefix);
+
+	for (i = 0; i < n; ++i)
+		buf[i] = digits[n - 1 - i];
+
+	buf[n] = '\0';
+}
+
+/**
+ * Adds one to the digits of @p buf (after @p skip characters) in @p base.
+ */
+static void
+increment(char *buf, size_t skip, int base)
+{
+	size_t i = strlen(buf);
+
+	while (i > skip) {
+		char *c = &(buf[--i]);
+		int d = (*c <= '9') ? *c - '0'
+			: (*c >= 'a') ? *c - 'a' + 10 : *c - 'A' + 10;
+
+		if (d + 1 < base) {
+			++d;
+			*c = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+			return;
+		}
+
+		*c = '0';
+	}
+
+	memmove(buf + skip + 1, buf + skip, strlen(buf + skip) + 1);
+	buf[skip] = '1';
+}
+
+/**
+ * The largest value of every width is accepted and one more isn't, in every
+ * base, spelled with a prefix for base 0 or without one.
+ */
+static void
+test_edges(void)
+{
+	static const struct {
+		int base; /**< Base to convert in */
+		int given; /**< Base passed to the conversion */
+		const char *prefix; /**< Prefix of the digits */
+	} bases[] = {
+		{ 2, 2, "" }, { 2, 0, "0b" }, { 2, 2, "0B" },
+		{ 8, 8, "" }, { 8, 0, "0o" },
+		{ 10, 10, "" }, { 10, 0, "" },
+		{ 16, 16, "" }, { 16, 0, "0x" }, { 16, 16, "0X" },
+		{ 36, 36, "" }
+	};
+	size_t t;
+	size_t b;
+
+	for (t = 0; t < TYPE_COUNT; ++t) {
+		const struct type *type = &(types[t]);
+
+		for (b = 0; b < sizeof(bases) / sizeof(bases[0]); ++b) {
+			char buf[80];
+			char neg[8];
+			int base = bases[b].base;
+			int given = bases[b].given;
+			size_t skip;
+
+			format(buf, bases[b].prefix, type->umax, base, b % 2 == 0);
+			check((enum width)t, buf, given, PANCL_SUCCESS,
+				narrow((enum width)t, type->umax));
+
+			skip = strlen(bases[b].prefix);
+			increment(buf, skip, base);
+			check((enum width)t, buf, given, PANCL_ERROR_STR_TO_INT_RANGE, 0);
+
+			if (!type->is_signed) {
+				format(buf, "-", 1, base, false);
+				check((enum width)t, buf, given,
+					PANCL_ERROR_STR_TO_INT_CHAR, 0);
+				continue;
+			}
+
+			sprintf(neg, "-%s", bases[b].prefix);
+			format(buf, neg, type->neg_max, base, b % 2 != 0);
+			check((enum width)t, buf, given, PANCL_SUCCESS,
+				narrow((enum width)t, (uint64_t)0 - type->neg_max));
+
+			increment(buf, strlen(neg), base);
+			check((enum width)t, buf, given, PANCL_ERROR_STR_TO_INT_RANGE, 0);
+		}
+	}
+}
+
+/**
+ * Inputs around the 8 digit chunks, and errors in the order a digit by digit
+ * conversion finds them.
+ */
+static void
+test_cases(void)
+{
+	static const struct {
+		enum width width;
+		const char *str;
+		int base;
+		int error;
+		uint64_t value;
+	} cases[] = {
+		/* One, two and two and a half chunks. */
+		{ UINT32, "12345678", 10, PANCL_SUCCESS, 12345678 },
+		{ UINT32, "00000000", 10, PANCL_SUCCESS, 0 },
+		{ UINT64, "1234567887654321", 10, PANCL_SUCCESS,
+			UINT64_C(1234567887654321) },
+		{ UINT64, "18446744073709551615", 10, PANCL_SUCCESS, UINT64_MAX },
+		{ UINT64, "18446744073709551616", 10,
+			PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT64, "99999999999999999999", 10,
+			PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT64, "00000000000000000001", 10, PANCL_SUCCESS, 1 },
+		{ UINT64, "000000000000000000018446744073709551615", 10,
+			PANCL_SUCCESS, UINT64_MAX },
+		{ UINT64, "123456789012345678901", 10,
+			PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT32, "FfFfFfFf", 16, PANCL_SUCCESS, UINT32_MAX },
+		{ UINT64, "fFfFfFfFFfFfFfFf", 16, PANCL_SUCCESS, UINT64_MAX },
+		{ UINT64, "0xDeadBeefCafeF00d", 0, PANCL_SUCCESS,
+			UINT64_C(0xdeadbeefcafef00d) },
+		{ UINT64, "00000000000000000000000000000001", 16, PANCL_SUCCESS, 1 },
+		{ UINT64, "10000000000000000", 16, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ INT64, "-9223372036854775808", 10, PANCL_SUCCESS,
+			UINT64_C(0x8000000000000000) },
+		{ INT64, "-0x8000000000000001", 0, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ INT8, "-0", 10, PANCL_SUCCESS, 0 },
+		{ UINT8, "+255", 10, PANCL_SUCCESS, 255 },
+
+		/* Whichever of a range and a character error comes first. */
+		{ UINT8, "256x", 10, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT8, "25x6", 10, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT64, "18446744073709551616x", 10,
+			PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT64, "1844674407370955161x6", 10,
+			PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT64, "1234567x", 10, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT64, "1234567812345678x", 10, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT32, "1FFFFFFFFg", 16, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT32, "FFFFFFFg1", 16, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT64, "1FFFFFFFFFFFFFFFFg", 16, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT8, "1000000002", 2, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT8, "12", 2, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT8, "400", 8, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT8, "0o778", 0, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT16, "1ekg", 36, PANCL_ERROR_STR_TO_INT_RANGE, 0 },
+		{ UINT16, "1ek-", 36, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+
+		/* Prefixes, bases and empty input. */
+		{ UINT8, "0x10", 10, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT8, "0b10", 16, PANCL_ERROR_STR_TO_INT_CHAR, 0 },
+		{ UINT8, "0x", 0, PANCL_SUCCESS, 0 },
+		{ UINT8, "", 10, PANCL_ERROR_ARG_INVALID, 0 },
+		{ UINT8, "1", 1, PANCL_ERROR_STR_TO_INT_BASE, 0 },
+		{ UINT8, "1", 37, PANCL_ERROR_STR_TO_INT_BASE, 0 }
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+		check(cases[i].width, cases[i].str, cases[i].base, cases[i].error,
+			cases[i].value);
+}
+
+/**
+ * Pseudo-random inputs of up to 24 characters give the same result as the
+ * reference, mostly digits of the base with the odd sign, prefix or invalid
+ * character.
+ */
+static void
+test_reference(void)
+{
+	static const int bases[] = { 0, 2, 3, 8, 10, 16, 36 };
+	static const char extra[] = "-+xXoObB z";
+	uint_least32_t state = 1;
+	int i;
+
+	for (i = 0; i < 200000; ++i) {
+		char buf[32];
+		int base;
+		int digits;
+		int len;
+		int j;
+		enum width width;
+		uint64_t bits;
+		uint64_t expected = 0;
+		int err;
+		int reference_err;
+
+		state = state * 1103515245u + 12345u;
+		width = (enum width)((state >> 16) % TYPE_COUNT);
+		state = state * 1103515245u + 12345u;
+		base = bases[(state >> 16) % (sizeof(bases) / sizeof(bases[0]))];
+		digits = (base == 0) ? 10 : base;
+		state = state * 1103515245u + 12345u;
+		len = 1 + (int)((state >> 16) % 24);
+
+		for (j = 0; j < len; ++j) {
+			int d;
+
+			state = state * 1103515245u + 12345u;
+			d = (int)((state >> 16) % 256);
+
+			if (d < 4) {
+				buf[j] = extra[(state >> 24) % (sizeof(extra) - 1)];
+				continue;
+			}
+
+			/* Mostly small digits, so values stay near the limits. */
+			d = (d < 64) ? d % digits : (d < 192) ? 0 : 1;
+			buf[j] = (char)(d < 10 ? '0' + d
+				: ((state >> 25) & 1) ? 'A' + d - 10 : 'a' + d - 10);
+		}
+
+		buf[len] = '\0';
+
+		err = convert(width, buf, base, &bits);
+		reference_err = reference(width, buf, base, &expected);
+
+		if (err != reference_err
+				|| (err == PANCL_SUCCESS && bits != expected)) {
+			fprintf(stderr, "%s(\"%s\", %d): got %d %llx, expected %d %llx\n",
+				types[width].name, buf, base, err, (unsigned long long)bits,
+				reference_err, (unsigned long long)expected);
+			TEST_CHECK(0);
+		}
+	}
+}
+
+/**
+ * The custom types reach the conversions with their base.
+ */
+static void
+test_document(void)
+{
+	static const char input[] =
+		"a = ::Int8(\"-128\")\n"
+		"b = ::Uint64(\"0xFFFFFFFFFFFFFFFF\")\n"
+		"c = ::Uint16(\"1EKF\", 36)\n"
+		"d = ::Int8(\"-129\")\n";
+	struct pancl_context ctx;
+	struct pancl_table table;
+	const struct pancl_table_data *td = &(table.data);
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+
+	/* The last entry isn't an Int8. */
+	TEST_CHECK(pancl_parse_buffer(&ctx, input, sizeof(input) - 1)
+		== PANCL_SUCCESS);
+	TEST_CHECK(pancl_get_next_table(&ctx, &table)
+		== PANCL_ERROR_STR_TO_INT_RANGE);
+	pancl_context_fini(&ctx);
+
+	pancl_context_init(&ctx);
+	TEST_CHECK(pancl_parse_buffer(&ctx, input, sizeof(input) - 20)
+		== PANCL_SUCCESS);
+	TEST_CHECK(pancl_get_next_table(&ctx, &table) == PANCL_SUCCESS);
+	TEST_CHECK(td->count == 3);
+
+	if (td->count == 3) {
+		TEST_CHECK(pancl_table_data_at(td, 0)->value.type
+			== PANCL_TYPE_OPT_INT8);
+		TEST_CHECK(pancl_table_data_at(td, 0)->value.data.opt.int8 == -128);
+		TEST_CHECK(pancl_table_data_at(td, 1)->value.data.opt.uint64
+			== UINT64_MAX);
+		TEST_CHECK(pancl_table_data_at(td, 2)->value.data.opt.uint16
+			== UINT16_MAX);
+	}
+
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+}
+
+int
+main(void)
+{
+	test_edges();
+	test_cases();
+	test_reference();
+	test_document();
+	return test_finish("test_int");
+}
+
+// vim:ts=4:sw=4:autoindent
@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_location.c
+ * @brief The bytes of the input each node spans.
+ */
+
+
+#if !defined(PANCL_NO_LOCATIONS)
+static const char document[] =
+	"a = 1\n"
+	"b = [2, 3]\n"
+	"[t]\n"
+	"c = { d = 4 }\n";
+
+/**
+ * Checks the line and span of a location.
+ */
+static void
+check_span(const struct pancl_location *loc, unsigned long line,
+	size_t offset, size_t length)
+{
+	TEST_CHECK(loc->line == line);
+	TEST_CHECK(loc->offset == offset);
+	TEST_CHECK(loc->length == length);
+}
+
+static void
+test_spans(void)
+{
+	struct pancl_context ctx;
+	struct pancl_table table;
+	const struct pancl_entry *entry;
+
+	pancl_context_init(&ctx);
+	pancl_table_init(&table);
+	TEST_CHECK(pancl_parse_buffer(&ctx, document, sizeof(document) - 1)
+		== PANCL_SUCCESS);
+
+	/* The root table runs from "a" to "]". */
+	TEST_CHECK(pancl_get_next_table(&ctx, &table) == PANCL_SUCCESS);
+	TEST_CHECK(table.data.count == 2);
+	check_span(&(table.loc), 0, 0, 16);
+	check_span(&(table.data.loc), 0, 0, 16);
+
+	entry = pancl_table_data_at(&(table.data), 1);
+	check_span(&(entry->loc), 1, 6, 10);
+	check_span(&(entry->value.loc), 1, 10, 6);
+	pancl_table_fini(&table);
+
+	/* "[t]" up to "}", with the braces as the inner table's data. */
+	pancl_table_init(&table);
+	TEST_CHECK(pancl_get_next_table(&ctx, &table) == PANCL_SUCCESS);
+	TEST_CHECK(table.data.count == 1);
+	check_span(&(table.loc), 2, 17, 17);
+	check_span(&(table.data.loc), 2, 17, 17);
+
+	entry = pancl_table_data_at(&(table.data), 0);
+	check_span(&(pancl_value_table(&(entry->value))->loc), 3, 25, 9);
+	pancl_table_fini(&table);
+
+	pancl_context_fini(&ctx);
+}
+#endif
+
+int
+main(void)
+{
+	/* Every table, entry and value embeds a location. */
+	TEST_CHECK(sizeof(struct pancl_location)
+		== 2 * sizeof(uint_least32_t) + 2 * sizeof(size_t));
+
+#if !defined(PANCL_NO_LOCATIONS)
+	test_spans();
+#endif
+	return test_finish("test_location");
+}
+
+// vim:ts=4:sw=4:autoindent
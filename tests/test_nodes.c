@@ -0,0 +1,226 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_nodes.c
+ * @brief Who owns the nodes of a parsed table.
+ */
+
+
+static const char document[] =
+	"a = [\"x\", \"y\", \"a string too long to be stored inline\"]\n"
+	"b = { c = (1, [2]) }\n"
+	"t = Foo(1, 2)\n"
+	"[second]\n"
+	"a = 1\n"
+	"[third]\n"
+	"key = \"value\"\n";
+
+/**
+ * Allocator state counting what is still allocated.
+ */
+struct counter {
+	long blocks; /**< Live blocks */
+	size_t bytes; /**< Live bytes, as told by the library */
+};
+
+static void *
+counter_alloc(void *state, size_t size)
+{
+	struct counter *c = state;
+	void *p = malloc(size);
+
+	if (p != NULL) {
+		c->blocks += 1;
+		c->bytes += size;
+	}
+
+	return p;
+}
+
+static void *
+counter_realloc(void *state, void *ptr, size_t old_size, size_t new_size)
+{
+	struct counter *c = state;
+	void *p = realloc(ptr, new_size);
+
+	if (p != NULL) {
+		c->bytes -= old_size;
+		c->bytes += new_size;
+	}
+
+	return p;
+}
+
+static void
+counter_free(void *state, void *ptr, size_t size)
+{
+	struct counter *c = state;
+
+	c->blocks -= 1;
+	c->bytes -= size;
+	free(ptr);
+}
+
+/**
+ * Parses the first table of the document.
+ */
+static void
+parse_first(struct pancl_context *ctx, struct pancl_table *table)
+{
+	pancl_table_init(table);
+	TEST_CHECK(pancl_parse_buffer(ctx, document, sizeof(document) - 1)
+		== PANCL_SUCCESS);
+	TEST_CHECK(pancl_get_next_table(ctx, table) == PANCL_SUCCESS);
+	TEST_CHECK(table->data.count == 3);
+}
+
+/**
+ * Nodes taken out of a table parsed the default way are separate heap
+ * blocks that pancl_*_destroy() can free on their own.
+ */
+static void
+test_destroy(void)
+{
+	struct pancl_context ctx;
+	struct pancl_table table;
+
+	pancl_context_init(&ctx);
+	parse_first(&ctx, &table);
+	TEST_CHECK(table.pool == NULL);
+
+#if !defined(PANCL_INLINE_CONTAINERS)
+	{
+		struct pancl_array *array;
+		struct pancl_entry *entry;
+		struct pancl_value *value;
+
+		array = pancl_value_array(&(pancl_table_data_at(&(table.data),
+				0)->value));
+		value = array->values[2];
+		array->count -= 1;
+		pancl_value_destroy(&value);
+		TEST_CHECK(value == NULL);
+
+		entry = table.data.entries[2];
+		table.data.count -= 1;
+		pancl_entry_destroy(&entry);
+		TEST_CHECK(entry == NULL);
+	}
+#endif
+
+#if !defined(PANCL_SSO_STRINGS)
+	{
+		struct pancl_entry *entry = pancl_table_data_at(&(table.data), 1);
+		struct pancl_utf8_string *name = entry->name;
+
+		entry->name = NULL;
+		pancl_utf8_string_destroy(&name);
+		TEST_CHECK(name == NULL);
+	}
+#endif
+
+	pancl_table_fini(&table);
+	pancl_context_fini(&ctx);
+}
+
+/**
+ * Tables only share the context's pool when asked to, and every mode hands
+ * all of its memory back in the end.
+ */
+static void
+test_sharing(unsigned int flags)
+{
+	struct counter counter = { 0, 0 };
+	struct pancl_allocator allocator = {
+		counter_alloc, counter_realloc, counter_free, &counter
+	};
+	struct pancl_context ctx;
+	struct pancl_table first;
+	struct pancl_table second;
+
+	pancl_context_init(&ctx);
+	ctx.flags = flags;
+	TEST_CHECK(pancl_context_set_allocator(&ctx, &allocator)
+		== PANCL_SUCCESS);
+
+	parse_first(&ctx, &first);
+	pancl_table_init(&second);
+	TEST_CHECK(pancl_get_next_table(&ctx, &second) == PANCL_SUCCESS);
+
+	TEST_CHECK(first.pool != NULL && second.pool != NULL);
+
+	if (flags == 0) {
+		TEST_CHECK(first.pool != second.pool);
+		TEST_CHECK(first.pool != ctx.pool);
+	}
+	else {
+		TEST_CHECK(first.pool == ctx.pool && second.pool == ctx.pool);
+	}
+
+	/* Tables may outlive the context. */
+	pancl_context_fini(&ctx);
+	pancl_table_fini(&first);
+	TEST_CHECK(pancl_table_shrink_to_fit(&second) == PANCL_SUCCESS);
+	pancl_table_fini(&second);
+
+	TEST_CHECK(counter.blocks == 0);
+	TEST_CHECK(counter.bytes == 0);
+}
+
+/**
+ * Whatever the memory comes from, the tables are the same.
+ */
+static void
+test_modes(void)
+{
+	static const unsigned int modes[] = {
+		PANCL_PARSE_RECYCLE,
+		PANCL_PARSE_ARENA,
+		PANCL_PARSE_INTERN_KEYS | PANCL_PARSE_INTERN_STRINGS,
+		PANCL_PARSE_RECYCLE | PANCL_PARSE_INTERN_KEYS
+	};
+	size_t i;
+	struct pancl_context ctx;
+	struct test_dump expected;
+	struct test_dump dump;
+
+	test_dump_init(&expected);
+	test_dump_parse(&expected, TEST_BUFFER, document, sizeof(document) - 1,
+		0);
+
+	for (i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+		test_sharing(modes[i]);
+
+		pancl_context_init(&ctx);
+		ctx.flags = modes[i];
+		TEST_CHECK(pancl_parse_buffer(&ctx, document, sizeof(document) - 1)
+			== PANCL_SUCCESS);
+
+		test_dump_init(&dump);
+		test_dump_context(&dump, &ctx);
+		TEST_CHECK(test_dump_equal(&expected, &dump));
+		test_dump_fini(&dump);
+
+		pancl_context_fini(&ctx);
+	}
+
+	test_dump_fini(&expected);
+}
+
+int
+main(void)
+{
+	test_destroy();
+	test_sharing(0);
+	test_modes();
+	return test_finish("test_nodes");
+}
+
+// vim:ts=4:sw=4:autoindent
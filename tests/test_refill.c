@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_refill.c
+ * @brief Reading the input in chunks must not change the result.
+ *
+ * Every document is parsed from memory in one piece, then from a file with
+ * read buffers of every size from PANCL_BUFFER_SIZE_MIN up to LARGEST_SIZE.
+ * That cuts each token, and each multi-byte UTF-8 sequence, at every
+ * possible position, and the dumps have to match.
+ */
+
+
+/**
+ * Largest read buffer tried; big enough that every split point in the
+ * short documents below is hit.
+ */
+#define LARGEST_SIZE  (72)
+
+#define DOCUMENT(text)  { text, sizeof(text) - 1 }
+
+/**
+ * One of each kind of token, in tables, containers and custom types.
+ */
+static const struct {
+	const char *text;
+	size_t size;
+} documents[] = {
+	DOCUMENT(
+		"# top comment \xc3\xa9\xe6\xbc\xa2\xf0\x9f\x98\x80\n"
+		"a = 1\n"
+		"b = -42\n"
+		"c = 0x1F\n"
+		"d = 0o17\n"
+		"e = 0b101\n"
+		"f = 1.5\n"
+		"g = .5e3\n"
+		"h = -Inf\n"
+		"i = NaN\n"
+		"j = true\n"
+		"k = false\n"
+		"s = \"hello\\tworld\\n\" 'raw\\n'  \"x\\x41\\101\\u00e9\\U0001F600\"\n"
+		"\"quoted \xe6\xbc\xa2 key\" = [1, 2, 3,]\n"
+		"t = (1, \"two\", 3.0, [true], {x = 1})\n"
+		"u = { a = 1, b = { c = [ (1,2), (3,4) ] } }\n"
+		"n = ::Int8(\"-12\")\n"
+		"n2 = ::Uint64(\"0xffffffffffffffff\", 0)\n"
+		"n3 = ::Integer(\"777\", 8)\n"
+		"w = ::Float(\"1.5\")\n"
+		"w2 = ::Float(\"ff.8\", 16)\n"
+		"cust = Foo(1, 2)\n"
+		"cust2 = Bar()\n"
+		"a.b:c+d-e_f = 6\n"
+		"long = \"line1\n"
+		"line2\r\n"
+		"line3\" \\\n"
+		"  \"cont\"\n"
+		"\n"
+		"[table1]\n"
+		"x = 5 # comment \xe2\x98\x83\n"
+		"y = \"\xc3\xa9 \xc3\xbc \xe6\xbc\xa2\xe5\xad\x97 \xf0\x9f\x98\x80\"\n"
+		"z = [\n"
+		"  \"a\",\n"
+		"  'b\xf0\x9f\x98\x80',\n"
+		"]\n"
+		"\n"
+		"[ \"table \xe2\x98\x83 2\" ]\n"
+		"big = 2147483647\n"
+		"small = -2147483648\n"
+		"ff = 1e308\n"
+		"[empty]\n"
+		"[last]\n"
+		"v = \"0123456789012345678901234567890123456789\"\n"),
+	/* CR LF and lone CR newlines. */
+	DOCUMENT(
+		"a = 1\r\n"
+		"b = \"x\r\ny\"\r\n"
+		"c = [1,\r2]\r"
+		"[t]\r\n"
+		"d = 'z'"),
+	/* Failures at the very end of the input. */
+	DOCUMENT("a = \"\xe2\x98"),
+	DOCUMENT("a = \"\xf0\x9f\x98"),
+	DOCUMENT("a = \"x\\"),
+	DOCUMENT("a = \"\\10"),
+	DOCUMENT("# \xe2\x98"),
+	DOCUMENT("\xe6\xbc"),
+	/* Failures in the middle of it. */
+	DOCUMENT("a = \"\xf8\x88\x80\x80\x80\"\nb = 1\n"),
+	DOCUMENT("a = \"\xe2\x28\xa1\"\nb = 1\n"),
+	DOCUMENT("a = \"\\400\"\nb = 1\n"),
+	DOCUMENT("a = [1, 2\nb = 1\n")
+};
+
+#undef DOCUMENT
+
+static void
+test_chunks(enum test_source source)
+{
+	size_t i;
+	size_t size;
+	struct test_dump whole;
+	struct test_dump chunked;
+
+	for (i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i) {
+		test_dump_init(&whole);
+		test_dump_parse(&whole, TEST_BUFFER, documents[i].text,
+			documents[i].size, 0);
+
+		for (size = PANCL_BUFFER_SIZE_MIN; size <= LARGEST_SIZE; ++size) {
+			test_dump_init(&chunked);
+			test_dump_parse(&chunked, source, documents[i].text,
+				documents[i].size, size);
+
+			if (!test_dump_equal(&whole, &chunked)) {
+				fprintf(stderr, "document %zu, buffer size %zu:\n%s"
+					"---\n%s", i, size, whole.data, chunked.data);
+			}
+
+			TEST_CHECK(test_dump_equal(&whole, &chunked));
+			test_dump_fini(&chunked);
+		}
+
+		test_dump_fini(&whole);
+	}
+}
+
+int
+main(void)
+{
+	test_chunks(TEST_FILE);
+	test_chunks(TEST_FD);
+	return test_finish("test_refill");
+}
+
+// vim:ts=4:sw=4:autoindent
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT */
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pancl/pancl.h"
+#include "test.h"
+
+/**
+ * @file test_utf8.c
+ * @brief UTF-8 handling that has to agree between all of the entry points.
+ */
+
+
+/**
+ * Overlong sequences decode to the shorter sequence.  Parsing from memory
+ * must not keep the original bytes just because the string could otherwise
+ * point into the input.
+ */
+static const struct {
+	const char *input;
+	size_t size;
+	const char *value;
+	size_t bytes;
+} overlong[] = {
+#define OVERLONG(input, value) \
+	{ input, sizeof(input) - 1, value, sizeof(value) - 1 }
+	OVERLONG("a = \"x\xc0\x80y\"\n", "x\0y"),
+	OVERLONG("a = 'x\xc0\x80y'\n", "x\0y"),
+	OVERLONG("a = \"\xc1\xbf\"\n", "\x7f"),
+	OVERLONG("a = \"x\xe0\x80\x80y\"\n", "x\0y"),
+	OVERLONG("a = \"\xe0\x83\xbf\"\n", "\xc3\xbf"),
+	OVERLONG("a = \"x\xf0\x80\x80\x80y\"\n", "x\0y"),
+	OVERLONG("a = \"\xf0\x8f\xbf\xbd\"\n", "\xef\xbf\xbd")
+#undef OVERLONG
+};
+
+static void
+test_overlong(void)
+{
+	size_t i;
+	struct test_dump buffer;
+	struct test_dump file;
+
+	for (i = 0; i < sizeof(overlong) / sizeof(overlong[0]); ++i) {
+		test_dump_init(&buffer);
+		test_dump_init(&file);
+
+		TEST_CHECK(test_string_value(overlong[i].input, overlong[i].size,
+			overlong[i].value, overlong[i].bytes));
+
+		test_dump_parse(&buffer, TEST_BUFFER, overlong[i].input,
+			overlong[i].size, 0);
+		test_dump_parse(&file, TEST_FILE, overlong[i].input,
+			overlong[i].size, 0);
+		TEST_CHECK(test_dump_equal(&buffer, &file));
+
+		test_dump_fini(&buffer);
+		test_dump_fini(&file);
+	}
+}
+
+int
+main(void)
+{
+	test_overlong();
+	return test_finish("test_utf8");
+}
+
+// vim:ts=4:sw=4:autoindent